@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Allineamento dei buffer dei vertici: una linea di cache, sufficiente anche per i registri AVX
+static const size_t BUFFER_ALIGNMENT = 64;
+
+// Allocatore per std::vector con memoria allineata a BUFFER_ALIGNMENT byte
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        if (count == 0) {
+            return nullptr;
+        }
+        void* memory = nullptr;
+#ifdef _WIN32
+        memory = _aligned_malloc(count * sizeof(T), BUFFER_ALIGNMENT);
+#else
+        if (posix_memalign(&memory, BUFFER_ALIGNMENT, count * sizeof(T)) != 0) {
+            memory = nullptr;
+        }
+#endif
+        if (!memory) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T* memory, size_t) {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        free(memory);
+#endif
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return false; }
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
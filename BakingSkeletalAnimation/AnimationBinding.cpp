@@ -0,0 +1,16 @@
+#include "AnimationBinding.h"
+
+AnimationBinding buildAnimationBinding(const Skeleton& skeleton, const aiAnimation* animation) {
+    AnimationBinding binding;
+
+    // Un solo passaggio sui canali: ogni canale viene agganciato al nodo con lo stesso nome
+    binding.nodeAnims.assign(skeleton.size(), nullptr);
+    for (unsigned int i = 0; i < animation->mNumChannels; i++) {
+        int nodeIndex = skeleton.findNode(animation->mChannels[i]->mNodeName);
+        if (nodeIndex >= 0 && !binding.nodeAnims[nodeIndex]) {
+            binding.nodeAnims[nodeIndex] = animation->mChannels[i];
+        }
+    }
+
+    return binding;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <vector>
+#include <assimp/anim.h>
+
+#include "Skeleton.h"
+
+// Associazione tra i nodi dello scheletro e i canali di un'animazione, costruita una sola volta
+// per coppia (scena, animazione). Ogni frame risolve il canale di un nodo con un accesso ad array
+// tramite l'indice del nodo nello scheletro, invece di confrontare stringhe.
+struct AnimationBinding {
+    std::vector<const aiNodeAnim*> nodeAnims; // nullptr se il nodo non e' animato
+};
+
+AnimationBinding buildAnimationBinding(const Skeleton& skeleton, const aiAnimation* animation);
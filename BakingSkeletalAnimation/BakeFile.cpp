@@ -0,0 +1,258 @@
+#include "BakeFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "HalfFloat.h"
+#include "Quantization.h"
+
+static uint64_t alignUp(uint64_t value) {
+    return (value + BAKE_FILE_ALIGNMENT - 1) / BAKE_FILE_ALIGNMENT * BAKE_FILE_ALIGNMENT;
+}
+
+static size_t positionComponentSize(PositionEncoding encoding) {
+    return encoding == PositionEncoding::Float32 ? sizeof(float) : sizeof(uint16_t);
+}
+
+static size_t normalComponentSize(NormalEncoding encoding) {
+    switch (encoding) {
+    case NormalEncoding::Float32:
+        return sizeof(float);
+    case NormalEncoding::Octahedral8:
+        return sizeof(int8_t);
+    default:
+        return sizeof(uint16_t);
+    }
+}
+
+static unsigned int normalPlanes(NormalEncoding encoding) {
+    return encoding == NormalEncoding::Octahedral16 || encoding == NormalEncoding::Octahedral8 ? 2 : 3;
+}
+
+static float vectorLength(float x, float y, float z) {
+    return std::sqrt(x * x + y * y + z * z);
+}
+
+// Codifica le posizioni di una mesh nei tre piani di block; restituisce l'errore massimo
+static float encodePositions(const VertexStream& positions, const BakeFileMesh& mesh, char* block) {
+    const float* planes[3] = { positions.x.data(), positions.y.data(), positions.z.data() };
+    if (mesh.positionEncoding == PositionEncoding::Float32) {
+        for (int c = 0; c < 3; c++) {
+            std::memcpy(block + c * mesh.positionStride, planes[c], mesh.numVertices * sizeof(float));
+        }
+        return 0.0f;
+    }
+
+    uint16_t* encoded[3];
+    float extent[3];
+    for (int c = 0; c < 3; c++) {
+        encoded[c] = reinterpret_cast<uint16_t*>(block + c * mesh.positionStride);
+        extent[c] = mesh.boundsMax[c] - mesh.boundsMin[c];
+    }
+    float maxError = 0.0f;
+    for (unsigned int i = 0; i < mesh.numVertices; i++) {
+        float error[3];
+        for (int c = 0; c < 3; c++) {
+            float decoded;
+            if (mesh.positionEncoding == PositionEncoding::Half) {
+                encoded[c][i] = floatToHalf(planes[c][i]);
+                decoded = halfToFloat(encoded[c][i]);
+            }
+            else {
+                encoded[c][i] = quantizeUnorm16(planes[c][i], mesh.boundsMin[c], extent[c]);
+                decoded = dequantizeUnorm16(encoded[c][i], mesh.boundsMin[c], extent[c]);
+            }
+            error[c] = decoded - planes[c][i];
+        }
+        maxError = std::max(maxError, vectorLength(error[0], error[1], error[2]));
+    }
+    return maxError;
+}
+
+// Codifica le normali di una mesh nei piani di block; restituisce l'errore angolare massimo
+static float encodeNormals(const VertexStream& normals, const BakeFileMesh& mesh, char* block) {
+    const float* planes[3] = { normals.x.data(), normals.y.data(), normals.z.data() };
+    float maxError = 0.0f;
+    switch (mesh.normalEncoding) {
+    case NormalEncoding::Float32:
+        for (int c = 0; c < 3; c++) {
+            std::memcpy(block + c * mesh.normalStride, planes[c], mesh.numVertices * sizeof(float));
+        }
+        break;
+
+    case NormalEncoding::Half: {
+        uint16_t* encoded[3];
+        for (int c = 0; c < 3; c++) {
+            encoded[c] = reinterpret_cast<uint16_t*>(block + c * mesh.normalStride);
+        }
+        for (unsigned int i = 0; i < mesh.numVertices; i++) {
+            float decoded[3];
+            for (int c = 0; c < 3; c++) {
+                encoded[c][i] = floatToHalf(planes[c][i]);
+                decoded[c] = halfToFloat(encoded[c][i]);
+            }
+            maxError = std::max(maxError, normalAngleError(planes[0][i], planes[1][i], planes[2][i], decoded[0], decoded[1], decoded[2]));
+        }
+        break;
+    }
+
+    default: {
+        const int bits = mesh.normalEncoding == NormalEncoding::Octahedral8 ? 8 : 16;
+        for (unsigned int i = 0; i < mesh.numVertices; i++) {
+            float u, v;
+            octahedralEncode(planes[0][i], planes[1][i], planes[2][i], u, v);
+            int32_t quantizedU = quantizeSnorm(u, bits);
+            int32_t quantizedV = quantizeSnorm(v, bits);
+            if (bits == 8) {
+                reinterpret_cast<int8_t*>(block)[i] = (int8_t)quantizedU;
+                reinterpret_cast<int8_t*>(block + mesh.normalStride)[i] = (int8_t)quantizedV;
+            }
+            else {
+                reinterpret_cast<int16_t*>(block)[i] = (int16_t)quantizedU;
+                reinterpret_cast<int16_t*>(block + mesh.normalStride)[i] = (int16_t)quantizedV;
+            }
+            float decoded[3];
+            octahedralDecode(dequantizeSnorm(quantizedU, bits), dequantizeSnorm(quantizedV, bits), decoded[0], decoded[1], decoded[2]);
+            maxError = std::max(maxError, normalAngleError(planes[0][i], planes[1][i], planes[2][i], decoded[0], decoded[1], decoded[2]));
+        }
+        break;
+    }
+    }
+    return maxError;
+}
+
+bool BakeFileWriter::open(const std::string& path, const std::vector<BakeMesh>& meshes, const std::vector<float>& frameTimes,
+    const BakeFileEncoding& encoding, const std::vector<BoundingBox>* clipBounds) {
+    if (encoding.positions == PositionEncoding::Unorm16 && !clipBounds) {
+        return false;
+    }
+    file.open(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // Calcola la posizione di ogni array prima di scrivere, cosi' le tabelle sono complete
+    std::memcpy(header.magic, BAKE_FILE_MAGIC, sizeof(header.magic));
+    header.version = BAKE_FILE_VERSION;
+    header.numMeshes = (uint32_t)meshes.size();
+    header.numFrames = (uint32_t)frameTimes.size();
+    header.meshTableOffset = alignUp(sizeof(BakeFileHeader));
+    header.frameTimesOffset = alignUp(header.meshTableOffset + meshes.size() * sizeof(BakeFileMesh));
+
+    uint64_t topologyOffset = alignUp(header.frameTimesOffset + frameTimes.size() * sizeof(float));
+    uint64_t frameOffset = 0;
+    meshTable.assign(meshes.size(), BakeFileMesh());
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const BakeMesh& mesh = meshes[i];
+        BakeFileMesh& entry = meshTable[i];
+        std::strncpy(entry.name, mesh.name.c_str(), sizeof(entry.name) - 1);
+        entry.numVertices = mesh.numVertices();
+        entry.numTriangles = mesh.numTriangles();
+        entry.flags = (mesh.normals.empty() ? 0 : BAKE_MESH_HAS_NORMALS) | (mesh.texCoordsU.empty() ? 0 : BAKE_MESH_HAS_TEXCOORDS);
+        entry.positionEncoding = encoding.positions;
+        entry.normalEncoding = encoding.normals;
+        entry.texCoordStride = alignUp(mesh.numVertices() * sizeof(float));
+        entry.positionStride = alignUp(mesh.numVertices() * positionComponentSize(encoding.positions));
+        entry.normalStride = alignUp(mesh.numVertices() * normalComponentSize(encoding.normals));
+        if (clipBounds && !(*clipBounds)[i].empty()) {
+            std::memcpy(entry.boundsMin, (*clipBounds)[i].minimum, sizeof(entry.boundsMin));
+            std::memcpy(entry.boundsMax, (*clipBounds)[i].maximum, sizeof(entry.boundsMax));
+        }
+
+        entry.indicesOffset = topologyOffset;
+        topologyOffset = alignUp(topologyOffset + mesh.indices.size() * sizeof(uint32_t));
+        if (entry.flags & BAKE_MESH_HAS_TEXCOORDS) {
+            entry.texCoordsOffset = topologyOffset;
+            topologyOffset += 2 * entry.texCoordStride;
+        }
+
+        entry.positionsOffset = frameOffset;
+        frameOffset += 3 * entry.positionStride;
+        if (entry.flags & BAKE_MESH_HAS_NORMALS) {
+            entry.normalsOffset = frameOffset;
+            frameOffset += normalPlanes(encoding.normals) * entry.normalStride;
+        }
+    }
+    frameBounds.assign(meshes.size(), BoundingBox());
+    header.firstFrameOffset = topologyOffset;
+    header.frameStride = frameOffset;
+    header.fileSize = header.firstFrameOffset + header.frameStride * frameTimes.size();
+
+    writeBytes(&header, sizeof(header));
+    padTo(header.meshTableOffset);
+    writeBytes(meshTable.data(), meshTable.size() * sizeof(BakeFileMesh));
+    padTo(header.frameTimesOffset);
+    writeBytes(frameTimes.data(), frameTimes.size() * sizeof(float));
+    for (size_t i = 0; i < meshes.size(); i++) {
+        padTo(meshTable[i].indicesOffset);
+        writeBytes(meshes[i].indices.data(), meshes[i].indices.size() * sizeof(uint32_t));
+        if (meshTable[i].flags & BAKE_MESH_HAS_TEXCOORDS) {
+            padTo(meshTable[i].texCoordsOffset);
+            writeBytes(meshes[i].texCoordsU.data(), meshes[i].texCoordsU.size() * sizeof(float));
+            padTo(meshTable[i].texCoordsOffset + meshTable[i].texCoordStride);
+            writeBytes(meshes[i].texCoordsV.data(), meshes[i].texCoordsV.size() * sizeof(float));
+        }
+    }
+    padTo(header.firstFrameOffset);
+    return !file.fail();
+}
+
+void BakeFileWriter::encodeFrame(const std::vector<SkinnedMesh>& skinnedMeshes, BakeFileFrame& frame) const {
+    // Il padding tra i piani resta a zero
+    frame.data.assign(header.frameStride, 0);
+    frame.bounds.assign(meshTable.size(), BoundingBox());
+    frame.positionErrors.assign(meshTable.size(), 0.0f);
+    frame.normalErrors.assign(meshTable.size(), 0.0f);
+    for (size_t i = 0; i < meshTable.size(); i++) {
+        const BakeFileMesh& mesh = meshTable[i];
+        frame.bounds[i].add(skinnedMeshes[i].positions);
+        frame.positionErrors[i] = encodePositions(skinnedMeshes[i].positions, mesh, frame.data.data() + mesh.positionsOffset);
+        if (mesh.flags & BAKE_MESH_HAS_NORMALS) {
+            frame.normalErrors[i] = encodeNormals(skinnedMeshes[i].normals, mesh, frame.data.data() + mesh.normalsOffset);
+        }
+    }
+}
+
+bool BakeFileWriter::writeFrame(const BakeFileFrame& frame) {
+    if (framesWritten >= header.numFrames) {
+        return false;
+    }
+
+    writeBytes(frame.data.data(), frame.data.size());
+    for (size_t i = 0; i < meshTable.size(); i++) {
+        frameBounds[i].add(frame.bounds[i]);
+        meshTable[i].maxPositionError = std::max(meshTable[i].maxPositionError, frame.positionErrors[i]);
+        meshTable[i].maxNormalError = std::max(meshTable[i].maxNormalError, frame.normalErrors[i]);
+    }
+    framesWritten++;
+    return !file.fail();
+}
+
+bool BakeFileWriter::close() {
+    // Riscrive la tabella delle mesh con i box e gli errori di tutti i frame. Con Unorm16 il box
+    // resta quello passato a open, su cui sono state quantizzate le posizioni.
+    for (size_t i = 0; i < meshTable.size(); i++) {
+        if (meshTable[i].positionEncoding != PositionEncoding::Unorm16 && !frameBounds[i].empty()) {
+            std::memcpy(meshTable[i].boundsMin, frameBounds[i].minimum, sizeof(meshTable[i].boundsMin));
+            std::memcpy(meshTable[i].boundsMax, frameBounds[i].maximum, sizeof(meshTable[i].boundsMax));
+        }
+    }
+    file.seekp((std::streamoff)header.meshTableOffset);
+    file.write(reinterpret_cast<const char*>(meshTable.data()), (std::streamsize)(meshTable.size() * sizeof(BakeFileMesh)));
+
+    file.close();
+    return !file.fail() && framesWritten == header.numFrames;
+}
+
+void BakeFileWriter::writeBytes(const void* data, size_t size) {
+    file.write(static_cast<const char*>(data), (std::streamsize)size);
+    position += size;
+}
+
+void BakeFileWriter::padTo(uint64_t offset) {
+    static const char zeros[BAKE_FILE_ALIGNMENT] = {};
+    while (position < offset) {
+        writeBytes(zeros, (size_t)std::min<uint64_t>(offset - position, sizeof(zeros)));
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "BakeMesh.h"
+#include "Skinning.h"
+
+// Formato binario dei frame calcolati (.bake), pensato per essere mappato in memoria e usato senza parsing.
+// Tutti i valori sono little endian e ogni array inizia a un multiplo di BAKE_FILE_ALIGNMENT byte.
+//
+//   BakeFileHeader
+//   BakeFileMesh[numMeshes]
+//   float frameTimes[numFrames]                  istanti dei frame, in tick dell'animazione
+//   topologia di ogni mesh, comune a tutti i frame: uint32_t indices[numTriangles * 3], float u[], v[]
+//   blocco del frame f a firstFrameOffset + f * frameStride, per ogni mesh:
+//     x[], y[], z[] delle posizioni e, se presenti, x[], y[], z[] (o u[], v[] ottaedrici) delle normali
+//
+// I piani di uno stesso array sono consecutivi e distano il rispettivo stride byte l'uno dall'altro.
+// Il tipo dei valori di posizioni e normali dipende dalla codifica scelta per la mesh.
+static const char BAKE_FILE_MAGIC[8] = { 'B', 'A', 'K', 'E', 'M', 'S', 'H', '\0' };
+static const uint32_t BAKE_FILE_VERSION = 2;
+static const uint64_t BAKE_FILE_ALIGNMENT = 64;
+
+// Valori di BakeFileMesh::flags
+static const uint32_t BAKE_MESH_HAS_NORMALS = 1 << 0;
+static const uint32_t BAKE_MESH_HAS_TEXCOORDS = 1 << 1;
+
+enum class PositionEncoding : uint32_t {
+    Float32,
+    Half,   // half IEEE
+    Unorm16 // uint16 normalizzato nel box della mesh sull'intera clip: boundsMin + q / 65535 * (boundsMax - boundsMin)
+};
+
+enum class NormalEncoding : uint32_t {
+    Float32,
+    Half,
+    Octahedral16, // due piani int16 della mappa ottaedrica, q / 32767
+    Octahedral8   // due piani int8 della mappa ottaedrica, q / 127
+};
+
+struct BakeFileEncoding {
+    PositionEncoding positions = PositionEncoding::Float32;
+    NormalEncoding normals = NormalEncoding::Float32;
+};
+
+struct BakeFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numMeshes;
+    uint32_t numFrames;
+    uint32_t reserved;
+    uint64_t meshTableOffset;
+    uint64_t frameTimesOffset;
+    uint64_t firstFrameOffset;
+    uint64_t frameStride;
+    uint64_t fileSize;
+};
+static_assert(sizeof(BakeFileHeader) == 64, "BakeFileHeader deve occupare 64 byte");
+
+struct BakeFileMesh {
+    char name[64];               // terminato da zero, troncato se piu' lungo
+    uint32_t numVertices;
+    uint32_t numTriangles;
+    uint32_t flags;
+    PositionEncoding positionEncoding;
+    NormalEncoding normalEncoding;
+    uint32_t reserved;
+    uint64_t texCoordStride;
+    uint64_t positionStride;
+    uint64_t normalStride;
+    uint64_t indicesOffset;      // dall'inizio del file
+    uint64_t texCoordsOffset;    // dall'inizio del file, 0 se la mesh non ha UV
+    uint64_t positionsOffset;    // dall'inizio del blocco del frame
+    uint64_t normalsOffset;      // dall'inizio del blocco del frame, 0 se la mesh non ha normali
+    float boundsMin[3];          // box delle posizioni sull'intera clip
+    float boundsMax[3];
+    float maxPositionError;      // errore massimo di codifica delle posizioni, nelle unita' della mesh
+    float maxNormalError;        // errore angolare massimo di codifica delle normali, in gradi
+    uint64_t padding[2];
+};
+static_assert(sizeof(BakeFileMesh) == 192, "BakeFileMesh deve occupare 192 byte");
+
+// Blocco di un frame gia' codificato, pronto per essere accodato al file
+struct BakeFileFrame {
+    AlignedVector<char> data;
+    std::vector<BoundingBox> bounds;
+    std::vector<float> positionErrors;
+    std::vector<float> normalErrors;
+};
+
+// Scrive un file .bake: open scrive intestazione, tabelle e topologia, poi i frame vengono codificati
+// con encodeFrame (anche da piu' thread) e accodati in ordine con writeFrame. Il numero di frame e'
+// fissato all'apertura; box ed errori delle mesh vengono completati da close.
+class BakeFileWriter {
+public:
+    // clipBounds (box delle posizioni di ogni mesh sull'intera clip) e' richiesto solo dalla codifica Unorm16
+    bool open(const std::string& path, const std::vector<BakeMesh>& meshes, const std::vector<float>& frameTimes,
+        const BakeFileEncoding& encoding, const std::vector<BoundingBox>* clipBounds = nullptr);
+
+    // Codifica un frame; skinnedMeshes segue l'ordine delle mesh passate a open
+    void encodeFrame(const std::vector<SkinnedMesh>& skinnedMeshes, BakeFileFrame& frame) const;
+
+    // Accoda il frame successivo
+    bool writeFrame(const BakeFileFrame& frame);
+
+    // Restituisce false se una scrittura e' fallita o se mancano dei frame
+    bool close();
+
+    const std::vector<BakeFileMesh>& meshes() const { return meshTable; }
+
+private:
+    void writeBytes(const void* data, size_t size);
+    void padTo(uint64_t offset);
+
+    std::ofstream file;
+    std::vector<BakeFileMesh> meshTable;
+    std::vector<BoundingBox> frameBounds; // box dei frame scritti, per mesh
+    BakeFileHeader header = {};
+    uint64_t position = 0;
+    unsigned int framesWritten = 0;
+};
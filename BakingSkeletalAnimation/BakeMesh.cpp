@@ -0,0 +1,71 @@
+#include "BakeMesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+BakeMesh buildBakeMesh(const aiMesh* mesh) {
+    BakeMesh bakeMesh;
+    const unsigned int numVertices = mesh->mNumVertices;
+    bakeMesh.name = mesh->mName.C_Str();
+
+    bakeMesh.positions.resize(numVertices);
+    for (unsigned int i = 0; i < numVertices; i++) {
+        bakeMesh.positions.x[i] = mesh->mVertices[i].x;
+        bakeMesh.positions.y[i] = mesh->mVertices[i].y;
+        bakeMesh.positions.z[i] = mesh->mVertices[i].z;
+    }
+
+    if (mesh->mNormals) {
+        bakeMesh.normals.resize(numVertices);
+        for (unsigned int i = 0; i < numVertices; i++) {
+            bakeMesh.normals.x[i] = mesh->mNormals[i].x;
+            bakeMesh.normals.y[i] = mesh->mNormals[i].y;
+            bakeMesh.normals.z[i] = mesh->mNormals[i].z;
+        }
+    }
+
+    // Le coordinate UV non dipendono dalla posa e vengono scritte cosi' come sono
+    if (mesh->HasTextureCoords(0)) {
+        bakeMesh.texCoordsU.resize(numVertices);
+        bakeMesh.texCoordsV.resize(numVertices);
+        for (unsigned int i = 0; i < numVertices; i++) {
+            bakeMesh.texCoordsU[i] = mesh->mTextureCoords[0][i].x;
+            bakeMesh.texCoordsV[i] = mesh->mTextureCoords[0][i].y;
+        }
+    }
+
+    // Dopo aiProcess_Triangulate restano solo triangoli, punti e linee
+    bakeMesh.indices.reserve((size_t)mesh->mNumFaces * 3);
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+        const aiFace& face = mesh->mFaces[i];
+        if (face.mNumIndices != 3) {
+            bakeMesh.numSkippedFaces++;
+            continue;
+        }
+        bakeMesh.indices.push_back(face.mIndices[0]);
+        bakeMesh.indices.push_back(face.mIndices[1]);
+        bakeMesh.indices.push_back(face.mIndices[2]);
+    }
+
+    return bakeMesh;
+}
+
+void BoundingBox::add(const VertexStream& points) {
+    for (size_t i = 0; i < points.size(); i++) {
+        minimum[0] = std::min(minimum[0], points.x[i]);
+        minimum[1] = std::min(minimum[1], points.y[i]);
+        minimum[2] = std::min(minimum[2], points.z[i]);
+        maximum[0] = std::max(maximum[0], points.x[i]);
+        maximum[1] = std::max(maximum[1], points.y[i]);
+        maximum[2] = std::max(maximum[2], points.z[i]);
+        finite = finite && std::isfinite(points.x[i]) && std::isfinite(points.y[i]) && std::isfinite(points.z[i]);
+    }
+}
+
+void BoundingBox::add(const BoundingBox& box) {
+    for (int c = 0; c < 3; c++) {
+        minimum[c] = std::min(minimum[c], box.minimum[c]);
+        maximum[c] = std::max(maximum[c], box.maximum[c]);
+    }
+    finite = finite && box.finite;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <string>
+#include <assimp/scene.h>
+
+#include "AlignedAllocator.h"
+
+// Componenti x, y, z di una sequenza di vettori in array separati (SoA)
+struct VertexStream {
+    AlignedVector<float> x;
+    AlignedVector<float> y;
+    AlignedVector<float> z;
+
+    void resize(size_t size) {
+        x.resize(size);
+        y.resize(size);
+        z.resize(size);
+    }
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+};
+
+// Box allineato agli assi; vuoto finche' non vi vengono aggiunti punti
+struct BoundingBox {
+    float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    bool finite = true; // false se e' stato aggiunto un punto inf o nan, che min e max ignorano
+
+    void add(const VertexStream& points);
+    void add(const BoundingBox& box);
+    bool empty() const { return minimum[0] > maximum[0]; }
+};
+
+// Geometria di una mesh in bind pose nel formato usato dal bake, convertita una sola volta dopo l'import:
+// flussi SoA allineati al posto degli aiVector3D e indici dei triangoli consecutivi al posto degli aiFace.
+struct BakeMesh {
+    std::string name; // aiMesh::mName, vuoto se la mesh non ha nome
+    VertexStream positions;
+    VertexStream normals; // vuoto se la mesh non ha normali
+    AlignedVector<float> texCoordsU; // primo canale UV (mTextureCoords[0]), vuoto se assente
+    AlignedVector<float> texCoordsV;
+    AlignedVector<uint32_t> indices; // tre indici per triangolo
+    unsigned int numSkippedFaces = 0; // facce che non sono triangoli (punti e linee), escluse da indices
+
+    unsigned int numVertices() const { return (unsigned int)positions.size(); }
+    unsigned int numTriangles() const { return (unsigned int)(indices.size() / 3); }
+};
+
+BakeMesh buildBakeMesh(const aiMesh* mesh);
@@ -0,0 +1,469 @@
+#include "BakeSequence.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Quantization.h"
+
+static const unsigned int MAX_RUN = 128;
+static const unsigned int NUM_POSITION_PLANES = 3;
+static const unsigned int NUM_NORMAL_PLANES = 2;
+
+static uint64_t alignUp(uint64_t value) {
+    return (value + BAKE_FILE_ALIGNMENT - 1) / BAKE_FILE_ALIGNMENT * BAKE_FILE_ALIGNMENT;
+}
+
+static unsigned int numPlanes(const BakeSequenceMesh& mesh) {
+    return NUM_POSITION_PLANES + ((mesh.flags & BAKE_MESH_HAS_NORMALS) ? NUM_NORMAL_PLANES : 0);
+}
+
+static size_t countValues(const BakeSequenceMesh* meshes, size_t numMeshes) {
+    size_t count = 0;
+    for (size_t i = 0; i < numMeshes; i++) {
+        count += (size_t)numPlanes(meshes[i]) * meshes[i].numVertices;
+    }
+    return count;
+}
+
+// Gli scarti piccoli, positivi o negativi, diventano valori piccoli: 0, -1, 1, -2 -> 0, 1, 2, 3
+static uint16_t zigzagEncode(uint16_t value) {
+    int16_t signedValue = (int16_t)value;
+    return (uint16_t)((uint16_t)(value << 1) ^ (uint16_t)(signedValue >> 15));
+}
+
+static uint16_t zigzagDecode(uint16_t value) {
+    return (uint16_t)((value >> 1) ^ (uint16_t)(0 - (value & 1)));
+}
+
+// Scarti dei valori del frame dalla previsione, vedi BakeSequence.h. Le operazioni sono modulo 2^16,
+// per cui la previsione puo' uscire dall'intervallo senza perdere la reversibilita'.
+static void computeResiduals(const BakeSequenceMesh* meshes, size_t numMeshes, unsigned int groupPosition, const uint16_t* current,
+    const uint16_t* previous, const uint16_t* beforePrevious, uint16_t* residuals) {
+    if (groupPosition == 0) {
+        for (size_t i = 0, value = 0; i < numMeshes; i++) {
+            for (unsigned int plane = 0; plane < numPlanes(meshes[i]); plane++) {
+                uint16_t predicted = 0;
+                for (unsigned int v = 0; v < meshes[i].numVertices; v++, value++) {
+                    residuals[value] = zigzagEncode((uint16_t)(current[value] - predicted));
+                    predicted = current[value];
+                }
+            }
+        }
+        return;
+    }
+
+    size_t numValues = countValues(meshes, numMeshes);
+    for (size_t i = 0; i < numValues; i++) {
+        uint16_t predicted = groupPosition == 1 ? previous[i] : (uint16_t)(2 * previous[i] - beforePrevious[i]);
+        residuals[i] = zigzagEncode((uint16_t)(current[i] - predicted));
+    }
+}
+
+static void applyResiduals(const BakeSequenceMesh* meshes, size_t numMeshes, unsigned int groupPosition, const uint16_t* residuals,
+    const uint16_t* previous, const uint16_t* beforePrevious, uint16_t* current) {
+    if (groupPosition == 0) {
+        for (size_t i = 0, value = 0; i < numMeshes; i++) {
+            for (unsigned int plane = 0; plane < numPlanes(meshes[i]); plane++) {
+                uint16_t predicted = 0;
+                for (unsigned int v = 0; v < meshes[i].numVertices; v++, value++) {
+                    current[value] = (uint16_t)(predicted + zigzagDecode(residuals[value]));
+                    predicted = current[value];
+                }
+            }
+        }
+        return;
+    }
+
+    size_t numValues = countValues(meshes, numMeshes);
+    for (size_t i = 0; i < numValues; i++) {
+        uint16_t predicted = groupPosition == 1 ? previous[i] : (uint16_t)(2 * previous[i] - beforePrevious[i]);
+        current[i] = (uint16_t)(predicted + zigzagDecode(residuals[i]));
+    }
+}
+
+// Codifica a corse di zeri di un piano di byte. Uno zero isolato resta nei letterali, dove costa un byte come una corsa.
+static void encodePlane(const uint8_t* plane, size_t size, std::vector<char>& output) {
+    size_t i = 0;
+    while (i < size) {
+        size_t length = 0;
+        if (plane[i] == 0) {
+            while (i + length < size && plane[i + length] == 0 && length < MAX_RUN) {
+                length++;
+            }
+            output.push_back((char)(0x80 | (length - 1)));
+        }
+        else {
+            while (i + length < size && length < MAX_RUN
+                && (plane[i + length] != 0 || (i + length + 1 < size && plane[i + length + 1] != 0))) {
+                length++;
+            }
+            output.push_back((char)(length - 1));
+            output.insert(output.end(), plane + i, plane + i + length);
+        }
+        i += length;
+    }
+}
+
+static bool decodePlane(const char*& input, const char* end, uint8_t* plane, size_t size) {
+    size_t i = 0;
+    while (i < size) {
+        if (input >= end) {
+            return false;
+        }
+        uint8_t control = (uint8_t)*input++;
+        size_t length = (control & 0x7F) + 1;
+        if (length > size - i) {
+            return false;
+        }
+        if (control & 0x80) {
+            std::memset(plane + i, 0, length);
+        }
+        else {
+            if ((size_t)(end - input) < length) {
+                return false;
+            }
+            std::memcpy(plane + i, input, length);
+            input += length;
+        }
+        i += length;
+    }
+    return true;
+}
+
+bool BakeSequenceWriter::open(const std::string& path, const std::vector<BakeMesh>& meshes, const std::vector<float>& frameTimes,
+    const std::vector<BoundingBox>& clipBounds, unsigned int keyframeInterval) {
+    if (keyframeInterval == 0 || clipBounds.size() != meshes.size()) {
+        return false;
+    }
+    file.open(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::memcpy(header.magic, BAKE_SEQUENCE_MAGIC, sizeof(header.magic));
+    header.version = BAKE_SEQUENCE_VERSION;
+    header.numMeshes = (uint32_t)meshes.size();
+    header.numFrames = (uint32_t)frameTimes.size();
+    header.keyframeInterval = keyframeInterval;
+    header.meshTableOffset = alignUp(sizeof(BakeSequenceHeader));
+    header.frameTimesOffset = alignUp(header.meshTableOffset + meshes.size() * sizeof(BakeSequenceMesh));
+    header.frameIndexOffset = alignUp(header.frameTimesOffset + frameTimes.size() * sizeof(float));
+
+    uint64_t topologyOffset = alignUp(header.frameIndexOffset + frameTimes.size() * sizeof(BakeSequenceFrame));
+    meshTable.assign(meshes.size(), BakeSequenceMesh());
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const BakeMesh& mesh = meshes[i];
+        BakeSequenceMesh& entry = meshTable[i];
+        std::strncpy(entry.name, mesh.name.c_str(), sizeof(entry.name) - 1);
+        entry.numVertices = mesh.numVertices();
+        entry.numTriangles = mesh.numTriangles();
+        entry.flags = (mesh.normals.empty() ? 0 : BAKE_MESH_HAS_NORMALS) | (mesh.texCoordsU.empty() ? 0 : BAKE_MESH_HAS_TEXCOORDS);
+        if (!clipBounds[i].empty()) {
+            std::memcpy(entry.boundsMin, clipBounds[i].minimum, sizeof(entry.boundsMin));
+            std::memcpy(entry.boundsMax, clipBounds[i].maximum, sizeof(entry.boundsMax));
+        }
+
+        entry.indicesOffset = topologyOffset;
+        topologyOffset = alignUp(topologyOffset + mesh.indices.size() * sizeof(uint32_t));
+        if (entry.flags & BAKE_MESH_HAS_TEXCOORDS) {
+            entry.texCoordsOffset = topologyOffset;
+            topologyOffset += 2 * alignUp(mesh.numVertices() * sizeof(float));
+        }
+    }
+    numValues = countValues(meshTable.data(), meshTable.size());
+    frameIndex.assign(frameTimes.size(), BakeSequenceFrame());
+    header.fileSize = topologyOffset;
+
+    // L'indice dei frame viene scritto a zero e completato da close
+    writeBytes(&header, sizeof(header));
+    padTo(header.meshTableOffset);
+    writeBytes(meshTable.data(), meshTable.size() * sizeof(BakeSequenceMesh));
+    padTo(header.frameTimesOffset);
+    writeBytes(frameTimes.data(), frameTimes.size() * sizeof(float));
+    padTo(header.frameIndexOffset);
+    writeBytes(frameIndex.data(), frameIndex.size() * sizeof(BakeSequenceFrame));
+    for (size_t i = 0; i < meshes.size(); i++) {
+        padTo(meshTable[i].indicesOffset);
+        writeBytes(meshes[i].indices.data(), meshes[i].indices.size() * sizeof(uint32_t));
+        if (meshTable[i].flags & BAKE_MESH_HAS_TEXCOORDS) {
+            padTo(meshTable[i].texCoordsOffset);
+            writeBytes(meshes[i].texCoordsU.data(), meshes[i].texCoordsU.size() * sizeof(float));
+            padTo(meshTable[i].texCoordsOffset + alignUp(meshTable[i].numVertices * sizeof(float)));
+            writeBytes(meshes[i].texCoordsV.data(), meshes[i].texCoordsV.size() * sizeof(float));
+        }
+    }
+    padTo(topologyOffset);
+    return !file.fail();
+}
+
+unsigned int BakeSequenceWriter::numGroups() const {
+    return (header.numFrames + header.keyframeInterval - 1) / header.keyframeInterval;
+}
+
+unsigned int BakeSequenceWriter::groupEndFrame(unsigned int group) const {
+    return std::min(header.numFrames, groupFirstFrame(group) + header.keyframeInterval);
+}
+
+void BakeSequenceWriter::beginGroup(BakeSequenceGroup& group) const {
+    group.data.clear();
+    group.frameSizes.clear();
+    group.positionErrors.assign(meshTable.size(), 0.0f);
+    group.normalErrors.assign(meshTable.size(), 0.0f);
+    group.framesEncoded = 0;
+}
+
+void BakeSequenceWriter::encodeFrame(const std::vector<SkinnedMesh>& skinnedMeshes, BakeSequenceGroup& group) const {
+    std::swap(group.beforePrevious, group.previous);
+    std::swap(group.previous, group.current);
+    group.current.resize(numValues);
+    group.residuals.resize(numValues);
+    group.planes.resize(2 * numValues);
+
+    // Quantizza posizioni e normali misurando l'errore rispetto ai valori ricostruiti
+    uint16_t* value = group.current.data();
+    for (size_t i = 0; i < meshTable.size(); i++) {
+        const BakeSequenceMesh& mesh = meshTable[i];
+        const VertexStream& positions = skinnedMeshes[i].positions;
+        const float* planes[3] = { positions.x.data(), positions.y.data(), positions.z.data() };
+        float extent[3];
+        for (int c = 0; c < 3; c++) {
+            extent[c] = mesh.boundsMax[c] - mesh.boundsMin[c];
+        }
+        for (unsigned int v = 0; v < mesh.numVertices; v++) {
+            float error[3];
+            for (int c = 0; c < 3; c++) {
+                uint16_t encoded = quantizeUnorm16(planes[c][v], mesh.boundsMin[c], extent[c]);
+                value[c * mesh.numVertices + v] = encoded;
+                error[c] = dequantizeUnorm16(encoded, mesh.boundsMin[c], extent[c]) - planes[c][v];
+            }
+            float length = std::sqrt(error[0] * error[0] + error[1] * error[1] + error[2] * error[2]);
+            group.positionErrors[i] = std::max(group.positionErrors[i], length);
+        }
+        value += NUM_POSITION_PLANES * mesh.numVertices;
+
+        if (mesh.flags & BAKE_MESH_HAS_NORMALS) {
+            const VertexStream& normals = skinnedMeshes[i].normals;
+            for (unsigned int v = 0; v < mesh.numVertices; v++) {
+                float u;
+                float w;
+                octahedralEncode(normals.x[v], normals.y[v], normals.z[v], u, w);
+                int32_t encodedU = quantizeSnorm(u, 16);
+                int32_t encodedV = quantizeSnorm(w, 16);
+                value[v] = (uint16_t)encodedU;
+                value[mesh.numVertices + v] = (uint16_t)encodedV;
+
+                float decoded[3];
+                octahedralDecode(dequantizeSnorm(encodedU, 16), dequantizeSnorm(encodedV, 16), decoded[0], decoded[1], decoded[2]);
+                group.normalErrors[i] = std::max(group.normalErrors[i],
+                    normalAngleError(normals.x[v], normals.y[v], normals.z[v], decoded[0], decoded[1], decoded[2]));
+            }
+            value += NUM_NORMAL_PLANES * mesh.numVertices;
+        }
+    }
+
+    computeResiduals(meshTable.data(), meshTable.size(), group.framesEncoded, group.current.data(),
+        group.previous.data(), group.beforePrevious.data(), group.residuals.data());
+
+    // Byte bassi e byte alti in due piani separati, cosi' gli zeri degli scarti piccoli sono consecutivi
+    for (size_t i = 0; i < numValues; i++) {
+        group.planes[i] = (uint8_t)(group.residuals[i] & 0xFF);
+        group.planes[numValues + i] = (uint8_t)(group.residuals[i] >> 8);
+    }
+    size_t frameBegin = group.data.size();
+    encodePlane(group.planes.data(), numValues, group.data);
+    encodePlane(group.planes.data() + numValues, numValues, group.data);
+    group.frameSizes.push_back(group.data.size() - frameBegin);
+    group.framesEncoded++;
+}
+
+bool BakeSequenceWriter::writeGroup(const BakeSequenceGroup& group) {
+    if (framesWritten + group.frameSizes.size() > header.numFrames) {
+        return false;
+    }
+
+    uint64_t frameOffset = position;
+    for (uint64_t size : group.frameSizes) {
+        frameIndex[framesWritten].offset = frameOffset;
+        frameIndex[framesWritten].size = size;
+        frameOffset += size;
+        framesWritten++;
+    }
+    writeBytes(group.data.data(), group.data.size());
+    for (size_t i = 0; i < meshTable.size(); i++) {
+        meshTable[i].maxPositionError = std::max(meshTable[i].maxPositionError, group.positionErrors[i]);
+        meshTable[i].maxNormalError = std::max(meshTable[i].maxNormalError, group.normalErrors[i]);
+    }
+    return !file.fail();
+}
+
+bool BakeSequenceWriter::close() {
+    // Riscrive intestazione, tabella delle mesh e indice dei frame con i valori finali
+    header.fileSize = position;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.seekp((std::streamoff)header.meshTableOffset);
+    file.write(reinterpret_cast<const char*>(meshTable.data()), (std::streamsize)(meshTable.size() * sizeof(BakeSequenceMesh)));
+    file.seekp((std::streamoff)header.frameIndexOffset);
+    file.write(reinterpret_cast<const char*>(frameIndex.data()), (std::streamsize)(frameIndex.size() * sizeof(BakeSequenceFrame)));
+
+    file.close();
+    return !file.fail() && framesWritten == header.numFrames;
+}
+
+void BakeSequenceWriter::writeBytes(const void* data, size_t size) {
+    file.write(static_cast<const char*>(data), (std::streamsize)size);
+    position += size;
+}
+
+void BakeSequenceWriter::padTo(uint64_t offset) {
+    static const char zeros[BAKE_FILE_ALIGNMENT] = {};
+    while (position < offset) {
+        writeBytes(zeros, (size_t)std::min<uint64_t>(offset - position, sizeof(zeros)));
+    }
+}
+
+// Vero se [offset, offset + size) e' interno al file
+static bool insideFile(uint64_t offset, uint64_t size, size_t fileSize) {
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+bool BakeSequenceReader::open(const char* data, size_t size) {
+    hasLastFrame = false;
+    if (reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0 || size < sizeof(BakeSequenceHeader)) {
+        return false;
+    }
+    const BakeSequenceHeader* candidate = reinterpret_cast<const BakeSequenceHeader*>(data);
+    if (std::memcmp(candidate->magic, BAKE_SEQUENCE_MAGIC, sizeof(candidate->magic)) != 0 || candidate->version != BAKE_SEQUENCE_VERSION
+        || candidate->keyframeInterval == 0 || candidate->fileSize > size
+        || candidate->meshTableOffset % BAKE_FILE_ALIGNMENT != 0 || candidate->frameTimesOffset % BAKE_FILE_ALIGNMENT != 0
+        || candidate->frameIndexOffset % BAKE_FILE_ALIGNMENT != 0
+        || !insideFile(candidate->meshTableOffset, (uint64_t)candidate->numMeshes * sizeof(BakeSequenceMesh), size)
+        || !insideFile(candidate->frameTimesOffset, (uint64_t)candidate->numFrames * sizeof(float), size)
+        || !insideFile(candidate->frameIndexOffset, (uint64_t)candidate->numFrames * sizeof(BakeSequenceFrame), size)) {
+        return false;
+    }
+
+    fileData = data;
+    fileSize = size;
+    fileHeader = candidate;
+    meshTable = reinterpret_cast<const BakeSequenceMesh*>(data + candidate->meshTableOffset);
+    frameTimes = reinterpret_cast<const float*>(data + candidate->frameTimesOffset);
+    frameIndex = reinterpret_cast<const BakeSequenceFrame*>(data + candidate->frameIndexOffset);
+    for (unsigned int frame = 0; frame < candidate->numFrames; frame++) {
+        if (!insideFile(frameIndex[frame].offset, frameIndex[frame].size, size)) {
+            return false;
+        }
+    }
+
+    numValues = countValues(meshTable, candidate->numMeshes);
+    current.resize(numValues);
+    previous.resize(numValues);
+    beforePrevious.resize(numValues);
+    residuals.resize(numValues);
+    planes.resize(2 * numValues);
+    return true;
+}
+
+bool BakeSequenceReader::decodeValues(unsigned int frame, unsigned int groupPosition) {
+    std::swap(beforePrevious, previous);
+    std::swap(previous, current);
+
+    const char* input = fileData + frameIndex[frame].offset;
+    const char* end = input + frameIndex[frame].size;
+    if (!decodePlane(input, end, planes.data(), numValues) || !decodePlane(input, end, planes.data() + numValues, numValues)) {
+        return false;
+    }
+    for (size_t i = 0; i < numValues; i++) {
+        residuals[i] = (uint16_t)(planes[i] | (planes[numValues + i] << 8));
+    }
+    applyResiduals(meshTable, fileHeader->numMeshes, groupPosition, residuals.data(), previous.data(), beforePrevious.data(), current.data());
+    return true;
+}
+
+bool BakeSequenceReader::decodeFrame(unsigned int frame, std::vector<SkinnedMesh>& skinnedMeshes) {
+    if (!fileHeader || frame >= fileHeader->numFrames) {
+        return false;
+    }
+
+    // Riparte dal keyframe del gruppo, a meno che l'ultimo frame decodificato non sia tra il keyframe e il frame richiesto
+    unsigned int keyframe = frame - frame % fileHeader->keyframeInterval;
+    unsigned int next = hasLastFrame && lastFrame >= keyframe && lastFrame <= frame ? lastFrame + 1 : keyframe;
+    for (unsigned int f = next; f <= frame; f++) {
+        if (!decodeValues(f, f - keyframe)) {
+            hasLastFrame = false;
+            return false;
+        }
+    }
+    lastFrame = frame;
+    hasLastFrame = true;
+
+    skinnedMeshes.resize(fileHeader->numMeshes);
+    const uint16_t* value = current.data();
+    for (unsigned int i = 0; i < fileHeader->numMeshes; i++) {
+        const BakeSequenceMesh& mesh = meshTable[i];
+        SkinnedMesh& skinnedMesh = skinnedMeshes[i];
+        skinnedMesh.positions.resize(mesh.numVertices);
+        float* planes[3] = { skinnedMesh.positions.x.data(), skinnedMesh.positions.y.data(), skinnedMesh.positions.z.data() };
+        for (int c = 0; c < 3; c++) {
+            float extent = mesh.boundsMax[c] - mesh.boundsMin[c];
+            for (unsigned int v = 0; v < mesh.numVertices; v++) {
+                planes[c][v] = dequantizeUnorm16(value[c * mesh.numVertices + v], mesh.boundsMin[c], extent);
+            }
+        }
+        value += NUM_POSITION_PLANES * mesh.numVertices;
+
+        if (mesh.flags & BAKE_MESH_HAS_NORMALS) {
+            skinnedMesh.normals.resize(mesh.numVertices);
+            for (unsigned int v = 0; v < mesh.numVertices; v++) {
+                octahedralDecode(dequantizeSnorm((int16_t)value[v], 16), dequantizeSnorm((int16_t)value[mesh.numVertices + v], 16),
+                    skinnedMesh.normals.x[v], skinnedMesh.normals.y[v], skinnedMesh.normals.z[v]);
+            }
+            value += NUM_NORMAL_PLANES * mesh.numVertices;
+        }
+        else {
+            skinnedMesh.normals.resize(0);
+        }
+    }
+    return true;
+}
+
+bool BakeSequenceReader::verifyFrame(unsigned int frame, const std::vector<SkinnedMesh>& expectedMeshes) {
+    if (!decodeFrame(frame, decodedMeshes) || expectedMeshes.size() != decodedMeshes.size()) {
+        return false;
+    }
+
+    // Gli errori vengono misurati come nel writer; il margine copre solo gli arrotondamenti dei float
+    for (unsigned int i = 0; i < fileHeader->numMeshes; i++) {
+        const BakeSequenceMesh& mesh = meshTable[i];
+        const VertexStream& expected = expectedMeshes[i].positions;
+        const VertexStream& decoded = decodedMeshes[i].positions;
+        if (expected.size() != mesh.numVertices) {
+            return false;
+        }
+        for (unsigned int v = 0; v < mesh.numVertices; v++) {
+            float dx = decoded.x[v] - expected.x[v];
+            float dy = decoded.y[v] - expected.y[v];
+            float dz = decoded.z[v] - expected.z[v];
+            if (!(std::sqrt(dx * dx + dy * dy + dz * dz) <= mesh.maxPositionError * 1.0001f + 1e-6f)) {
+                return false;
+            }
+        }
+
+        if (mesh.flags & BAKE_MESH_HAS_NORMALS) {
+            const VertexStream& expectedNormals = expectedMeshes[i].normals;
+            const VertexStream& decodedNormals = decodedMeshes[i].normals;
+            if (expectedNormals.size() != mesh.numVertices) {
+                return false;
+            }
+            for (unsigned int v = 0; v < mesh.numVertices; v++) {
+                float error = normalAngleError(expectedNormals.x[v], expectedNormals.y[v], expectedNormals.z[v],
+                    decodedNormals.x[v], decodedNormals.y[v], decodedNormals.z[v]);
+                if (!(error <= mesh.maxNormalError * 1.0001f + 1e-4f)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "BakeFile.h"
+#include "BakeMesh.h"
+#include "Skinning.h"
+
+// Formato compresso di una clip calcolata (.bakeseq). I frame sono divisi in gruppi di keyframeInterval
+// frame: il primo di ogni gruppo (keyframe) si decodifica da solo, gli altri come differenza dai frame
+// precedenti dello stesso gruppo, per cui qualsiasi frame si ricostruisce decodificando al piu'
+// keyframeInterval frame. Tutti i valori sono little endian.
+//
+//   BakeSequenceHeader
+//   BakeSequenceMesh[numMeshes]
+//   float frameTimes[numFrames]                  istanti dei frame, in tick dell'animazione
+//   BakeSequenceFrame frameIndex[numFrames]      posizione e dimensione dei dati di ogni frame
+//   topologia di ogni mesh, comune a tutti i frame: uint32_t indices[numTriangles * 3], float u[], v[]
+//   dati dei frame, in ordine e senza padding
+//
+// Ogni frame contiene i valori a 16 bit di tutte le mesh in sequenza, per ogni mesh i piani x, y, z
+// delle posizioni (unorm16 nel box della mesh sull'intera clip) e, se presenti, u, v delle normali
+// (int16 della mappa ottaedrica, q / 32767). Al posto dei valori viene salvato lo scarto da una
+// previsione: nel keyframe il valore precedente dello stesso piano, negli altri frame il valore del
+// frame precedente o, dal terzo frame del gruppo, l'estrapolazione lineare dei due frame precedenti.
+// Gli scarti (modulo 2^16) vengono codificati a zigzag e separati in due piani di byte, prima tutti
+// i byte bassi e poi tutti gli alti; ciascun piano e' compresso con una codifica a corse di zeri:
+// un byte di controllo c < 128 e' seguito da c + 1 byte letterali, c >= 128 vale c - 127 byte a zero.
+// I piani restano adatti a un ulteriore compressore generico (zstd, 7z) per l'archiviazione.
+static const char BAKE_SEQUENCE_MAGIC[8] = { 'B', 'A', 'K', 'E', 'S', 'E', 'Q', '\0' };
+static const uint32_t BAKE_SEQUENCE_VERSION = 1;
+
+struct BakeSequenceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numMeshes;
+    uint32_t numFrames;
+    uint32_t keyframeInterval;
+    uint64_t meshTableOffset;
+    uint64_t frameTimesOffset;
+    uint64_t frameIndexOffset;
+    uint64_t fileSize;
+    uint64_t reserved;
+};
+static_assert(sizeof(BakeSequenceHeader) == 64, "BakeSequenceHeader deve occupare 64 byte");
+
+struct BakeSequenceMesh {
+    char name[64];               // terminato da zero, troncato se piu' lungo
+    uint32_t numVertices;
+    uint32_t numTriangles;
+    uint32_t flags;              // BAKE_MESH_HAS_NORMALS, BAKE_MESH_HAS_TEXCOORDS
+    uint32_t reserved;
+    uint64_t indicesOffset;      // dall'inizio del file
+    uint64_t texCoordsOffset;    // dall'inizio del file, 0 se la mesh non ha UV; v[] segue u[] al multiplo di 64 byte successivo
+    float boundsMin[3];          // box delle posizioni sull'intera clip, su cui sono quantizzate
+    float boundsMax[3];
+    float maxPositionError;      // errore massimo di quantizzazione delle posizioni, nelle unita' della mesh
+    float maxNormalError;        // errore angolare massimo di quantizzazione delle normali, in gradi
+};
+static_assert(sizeof(BakeSequenceMesh) == 128, "BakeSequenceMesh deve occupare 128 byte");
+
+struct BakeSequenceFrame {
+    uint64_t offset;             // dall'inizio del file
+    uint64_t size;
+};
+
+// Gruppo di frame codificato da un thread: i frame di un gruppo dipendono dai precedenti, per cui
+// vengono codificati in ordine dallo stesso thread, mentre gruppi diversi sono indipendenti
+struct BakeSequenceGroup {
+    std::vector<char> data;             // frame codificati, uno dopo l'altro
+    std::vector<uint64_t> frameSizes;
+    std::vector<float> positionErrors;  // per mesh
+    std::vector<float> normalErrors;
+
+    // Valori quantizzati del frame corrente e dei due precedenti, scarti e piani di byte
+    std::vector<uint16_t> current;
+    std::vector<uint16_t> previous;
+    std::vector<uint16_t> beforePrevious;
+    std::vector<uint16_t> residuals;
+    std::vector<uint8_t> planes;
+    unsigned int framesEncoded = 0;
+};
+
+// Scrive un file .bakeseq: open scrive intestazione, tabelle e topologia, poi ogni gruppo viene
+// codificato frame per frame con beginGroup e encodeFrame (gruppi diversi anche da thread diversi)
+// e accodato in ordine con writeGroup. close completa l'indice dei frame e gli errori delle mesh.
+class BakeSequenceWriter {
+public:
+    // clipBounds contiene il box delle posizioni di ogni mesh sull'intera clip
+    bool open(const std::string& path, const std::vector<BakeMesh>& meshes, const std::vector<float>& frameTimes,
+        const std::vector<BoundingBox>& clipBounds, unsigned int keyframeInterval);
+
+    unsigned int numGroups() const;
+    unsigned int groupFirstFrame(unsigned int group) const { return group * header.keyframeInterval; }
+    unsigned int groupEndFrame(unsigned int group) const;
+
+    void beginGroup(BakeSequenceGroup& group) const;
+
+    // Codifica il frame successivo del gruppo; skinnedMeshes segue l'ordine delle mesh passate a open
+    void encodeFrame(const std::vector<SkinnedMesh>& skinnedMeshes, BakeSequenceGroup& group) const;
+
+    // Accoda il gruppo successivo
+    bool writeGroup(const BakeSequenceGroup& group);
+
+    // Restituisce false se una scrittura e' fallita o se mancano dei frame
+    bool close();
+
+    const std::vector<BakeSequenceMesh>& meshes() const { return meshTable; }
+    uint64_t fileSize() const { return header.fileSize; }
+
+private:
+    void writeBytes(const void* data, size_t size);
+    void padTo(uint64_t offset);
+
+    std::ofstream file;
+    std::vector<BakeSequenceMesh> meshTable;
+    std::vector<BakeSequenceFrame> frameIndex;
+    BakeSequenceHeader header = {};
+    uint64_t position = 0;
+    size_t numValues = 0; // valori a 16 bit di un frame
+    unsigned int framesWritten = 0;
+};
+
+// Accesso casuale ai frame di un file .bakeseq gia' in memoria, per esempio mappato dal disco.
+// Il lettore ricorda l'ultimo frame decodificato: leggendo i frame in ordine ognuno costa un solo
+// frame, altrimenti si riparte dal keyframe del gruppo.
+class BakeSequenceReader {
+public:
+    // data deve restare valido finche' si usa il lettore; restituisce false se il file non e' valido
+    bool open(const char* data, size_t size);
+
+    const BakeSequenceHeader& header() const { return *fileHeader; }
+    const BakeSequenceMesh& mesh(unsigned int index) const { return meshTable[index]; }
+    float frameTime(unsigned int frame) const { return frameTimes[frame]; }
+
+    // Ricostruisce posizioni e normali di tutte le mesh al frame richiesto (le normali restano vuote
+    // per le mesh che non le hanno); restituisce false se i dati del frame non sono validi
+    bool decodeFrame(unsigned int frame, std::vector<SkinnedMesh>& skinnedMeshes);
+
+    // Decodifica il frame e lo confronta con le mesh da cui e' stato codificato; restituisce false se i
+    // dati del frame non sono validi o se una mesh supera gli errori massimi registrati nel file
+    bool verifyFrame(unsigned int frame, const std::vector<SkinnedMesh>& expectedMeshes);
+
+private:
+    bool decodeValues(unsigned int frame, unsigned int groupPosition);
+
+    const char* fileData = nullptr;
+    size_t fileSize = 0;
+    const BakeSequenceHeader* fileHeader = nullptr;
+    const BakeSequenceMesh* meshTable = nullptr;
+    const float* frameTimes = nullptr;
+    const BakeSequenceFrame* frameIndex = nullptr;
+    size_t numValues = 0;
+    unsigned int lastFrame = 0;
+    bool hasLastFrame = false;
+
+    std::vector<uint16_t> current;
+    std::vector<uint16_t> previous;
+    std::vector<uint16_t> beforePrevious;
+    std::vector<uint16_t> residuals;
+    std::vector<uint8_t> planes;
+    std::vector<SkinnedMesh> decodedMeshes; // usato da verifyFrame
+};
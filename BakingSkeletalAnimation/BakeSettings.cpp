@@ -0,0 +1,274 @@
+#include "BakeSettings.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Frequenza usata da Assimp quando il file non specifica i tick al secondo
+static const double DEFAULT_TICKS_PER_SECOND = 25.0;
+
+// strtof accetta anche inf e nan, che nessuna opzione ammette
+static bool parseFloat(const char* text, float& value) {
+    char* end = nullptr;
+    value = std::strtof(text, &end);
+    return end != text && *end == '\0' && std::isfinite(value);
+}
+
+// Posizione del punto dell'estensione nel nome del file, npos se il nome non ha estensione
+static size_t findExtension(const std::string& path) {
+    size_t extension = path.find_last_of('.');
+    size_t separator = path.find_last_of("/\\");
+    if (extension == std::string::npos || (separator != std::string::npos && extension < separator)) {
+        return std::string::npos;
+    }
+    return extension;
+}
+
+static void printUsage() {
+    std::cout << "Uso: BakingSkeletalAnimation [--input file | --synthetic bones=n,vertices=n,...] [--output file.obj] [--animation indice]" << std::endl;
+    std::cout << "                             [--scene-cache file]" << std::endl;
+    std::cout << "                             [--time t | --start t --end t (--step t | --fps n)] [--threads n]" << std::endl;
+    std::cout << "                             [--format obj|bin|both|vat|seq] [--precision cifre]" << std::endl;
+    std::cout << "                             [--position-encoding float|half|unorm16] [--normal-encoding float|half|oct16|oct8]" << std::endl;
+    std::cout << "                             [--vat-format float|half] [--vat-normals on|off]" << std::endl;
+    std::cout << "                             [--keyframe-interval n] [--verify n]" << std::endl;
+    std::cout << "                             [--sampled-tracks on|off] [--track-cache file]" << std::endl;
+    std::cout << "                             [--skinning serial|parallel|auto] [--parallel-threshold vertici]" << std::endl;
+    std::cout << "                             [--kernel auto|scalar|sse41|avx2] [--profile trace.json]" << std::endl;
+}
+
+bool parseBakeSettings(int argc, char* argv[], BakeSettings& settings) {
+    for (int i = 1; i < argc; i++) {
+        const char* option = argv[i];
+        if (i + 1 >= argc) {
+            std::cout << "Valore mancante per l'opzione " << option << std::endl;
+            printUsage();
+            return false;
+        }
+        const char* value = argv[++i];
+
+        float number = 0.0f;
+        bool valid = true;
+        if (std::strcmp(option, "--input") == 0) {
+            settings.inputPath = value;
+        }
+        else if (std::strcmp(option, "--scene-cache") == 0) {
+            settings.sceneCachePath = value;
+        }
+        else if (std::strcmp(option, "--synthetic") == 0) {
+            valid = parseSyntheticSceneSettings(value, settings.syntheticScene);
+            settings.syntheticInput = true;
+        }
+        else if (std::strcmp(option, "--output") == 0) {
+            settings.outputPath = value;
+        }
+        else if (std::strcmp(option, "--animation") == 0) {
+            valid = parseFloat(value, number) && number >= 0.0f;
+            settings.animationIndex = (unsigned int)number;
+        }
+        else if (std::strcmp(option, "--time") == 0 || std::strcmp(option, "--start") == 0) {
+            valid = parseFloat(value, settings.startTime);
+        }
+        else if (std::strcmp(option, "--end") == 0) {
+            valid = parseFloat(value, settings.endTime);
+            settings.bakeRange = true;
+        }
+        else if (std::strcmp(option, "--step") == 0) {
+            valid = parseFloat(value, settings.timeStep) && settings.timeStep > 0.0f;
+            settings.bakeRange = true;
+        }
+        else if (std::strcmp(option, "--fps") == 0) {
+            valid = parseFloat(value, settings.framesPerSecond) && settings.framesPerSecond > 0.0f;
+            settings.bakeRange = true;
+        }
+        else if (std::strcmp(option, "--format") == 0) {
+            if (std::strcmp(value, "bin") == 0) {
+                settings.outputFormat = OutputFormat::Binary;
+            }
+            else if (std::strcmp(value, "both") == 0) {
+                settings.outputFormat = OutputFormat::Both;
+            }
+            else if (std::strcmp(value, "vat") == 0) {
+                settings.outputFormat = OutputFormat::Vat;
+            }
+            else if (std::strcmp(value, "seq") == 0) {
+                settings.outputFormat = OutputFormat::Sequence;
+            }
+            else {
+                valid = std::strcmp(value, "obj") == 0;
+                settings.outputFormat = OutputFormat::Obj;
+            }
+        }
+        else if (std::strcmp(option, "--position-encoding") == 0) {
+            if (std::strcmp(value, "half") == 0) {
+                settings.binaryEncoding.positions = PositionEncoding::Half;
+            }
+            else if (std::strcmp(value, "unorm16") == 0) {
+                settings.binaryEncoding.positions = PositionEncoding::Unorm16;
+            }
+            else {
+                valid = std::strcmp(value, "float") == 0;
+                settings.binaryEncoding.positions = PositionEncoding::Float32;
+            }
+        }
+        else if (std::strcmp(option, "--normal-encoding") == 0) {
+            if (std::strcmp(value, "half") == 0) {
+                settings.binaryEncoding.normals = NormalEncoding::Half;
+            }
+            else if (std::strcmp(value, "oct16") == 0) {
+                settings.binaryEncoding.normals = NormalEncoding::Octahedral16;
+            }
+            else if (std::strcmp(value, "oct8") == 0) {
+                settings.binaryEncoding.normals = NormalEncoding::Octahedral8;
+            }
+            else {
+                valid = std::strcmp(value, "float") == 0;
+                settings.binaryEncoding.normals = NormalEncoding::Float32;
+            }
+        }
+        else if (std::strcmp(option, "--vat-format") == 0) {
+            valid = std::strcmp(value, "float") == 0 || std::strcmp(value, "half") == 0;
+            settings.vatFormat = std::strcmp(value, "half") == 0 ? VatFormat::Half : VatFormat::Float;
+        }
+        else if (std::strcmp(option, "--vat-normals") == 0) {
+            valid = std::strcmp(value, "on") == 0 || std::strcmp(value, "off") == 0;
+            settings.vatNormals = std::strcmp(value, "on") == 0;
+        }
+        else if (std::strcmp(option, "--keyframe-interval") == 0) {
+            valid = parseFloat(value, number) && number >= 1.0f;
+            settings.keyframeInterval = (unsigned int)number;
+        }
+        else if (std::strcmp(option, "--verify") == 0) {
+            valid = parseFloat(value, number) && number >= 0.0f;
+            settings.verifyFrames = (unsigned int)number;
+        }
+        else if (std::strcmp(option, "--precision") == 0) {
+            valid = parseFloat(value, number) && number >= 0.0f;
+            settings.objPrecision = (int)number;
+        }
+        else if (std::strcmp(option, "--sampled-tracks") == 0) {
+            valid = std::strcmp(value, "on") == 0 || std::strcmp(value, "off") == 0;
+            settings.sampledTracks = std::strcmp(value, "on") == 0;
+        }
+        else if (std::strcmp(option, "--track-cache") == 0) {
+            settings.trackCachePath = value;
+        }
+        else if (std::strcmp(option, "--profile") == 0) {
+            settings.profilePath = value;
+        }
+        else if (std::strcmp(option, "--threads") == 0) {
+            valid = parseFloat(value, number) && number >= 0.0f;
+            settings.numThreads = (unsigned int)number;
+        }
+        else if (std::strcmp(option, "--skinning") == 0) {
+            if (std::strcmp(value, "serial") == 0) {
+                settings.skinningMode = SkinningMode::Serial;
+            }
+            else if (std::strcmp(value, "parallel") == 0) {
+                settings.skinningMode = SkinningMode::Parallel;
+            }
+            else {
+                valid = std::strcmp(value, "auto") == 0;
+                settings.skinningMode = SkinningMode::Automatic;
+            }
+        }
+        else if (std::strcmp(option, "--parallel-threshold") == 0) {
+            valid = parseFloat(value, number) && number >= 0.0f;
+            settings.parallelSkinningThreshold = (unsigned int)number;
+        }
+        else if (std::strcmp(option, "--kernel") == 0) {
+            if (std::strcmp(value, "scalar") == 0) {
+                settings.skinningKernel = SkinningKernel::Scalar;
+            }
+            else if (std::strcmp(value, "sse41") == 0) {
+                settings.skinningKernel = SkinningKernel::Sse41;
+            }
+            else if (std::strcmp(value, "avx2") == 0) {
+                settings.skinningKernel = SkinningKernel::Avx2;
+            }
+            else {
+                valid = std::strcmp(value, "auto") == 0;
+                settings.skinningKernel = SkinningKernel::Automatic;
+            }
+        }
+        else {
+            std::cout << "Opzione sconosciuta: " << option << std::endl;
+            printUsage();
+            return false;
+        }
+
+        if (!valid) {
+            std::cout << "Valore non valido per l'opzione " << option << ": " << value << std::endl;
+            return false;
+        }
+    }
+
+    if (settings.outputFormat == OutputFormat::Vat || settings.outputFormat == OutputFormat::Sequence) {
+        settings.bakeRange = true;
+    }
+    return true;
+}
+
+bool computeFrameTimes(const BakeSettings& settings, const aiAnimation* animation, std::vector<float>& frameTimes) {
+    frameTimes.clear();
+    if (!settings.bakeRange) {
+        frameTimes.push_back(settings.startTime);
+        return true;
+    }
+
+    double endTime = settings.endTime >= 0.0f ? settings.endTime : animation->mDuration;
+    double timeStep = settings.timeStep > 0.0f ? settings.timeStep : 1.0;
+    if (settings.framesPerSecond > 0.0f) {
+        double ticksPerSecond = animation->mTicksPerSecond > 0.0 ? animation->mTicksPerSecond : DEFAULT_TICKS_PER_SECOND;
+        timeStep = ticksPerSecond / settings.framesPerSecond;
+    }
+
+    // Il numero di frame viene controllato prima del ciclo: una durata non finita o un passo minuscolo
+    // rispetto all'intervallo non devono esaurire la memoria
+    const double tolerance = timeStep * 1e-4;
+    const double numSteps = (endTime + tolerance - settings.startTime) / timeStep;
+    if (!std::isfinite(numSteps) || numSteps >= MAX_BAKE_FRAMES) {
+        std::cout << "L'intervallo da " << settings.startTime << " a " << endTime << " con passo " << timeStep
+            << " contiene troppi frame (al massimo " << MAX_BAKE_FRAMES << ")" << std::endl;
+        return false;
+    }
+
+    // Ogni tempo e' calcolato dall'indice del frame per non accumulare errori di arrotondamento
+    for (unsigned int frame = 0; settings.startTime + frame * timeStep <= endTime + tolerance; frame++) {
+        frameTimes.push_back((float)(settings.startTime + frame * timeStep));
+    }
+    if (frameTimes.empty()) {
+        std::cout << "L'intervallo da " << settings.startTime << " a " << endTime << " non contiene nessun frame" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string frameOutputPath(const std::string& outputPath, unsigned int frameIndex, size_t numFrames) {
+    if (numFrames <= 1) {
+        return outputPath;
+    }
+
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "_%04u", frameIndex);
+
+    size_t extension = findExtension(outputPath);
+    if (extension == std::string::npos) {
+        return outputPath + suffix;
+    }
+    return outputPath.substr(0, extension) + suffix + outputPath.substr(extension);
+}
+
+std::string outputBasePath(const std::string& outputPath) {
+    return outputPath.substr(0, findExtension(outputPath));
+}
+
+std::string binaryOutputPath(const std::string& outputPath) {
+    return outputBasePath(outputPath) + ".bake";
+}
+
+std::string sequenceOutputPath(const std::string& outputPath) {
+    return outputBasePath(outputPath) + ".bakeseq";
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <assimp/anim.h>
+
+#include "BakeFile.h"
+#include "Skinning.h"
+#include "SyntheticScene.h"
+#include "VatWriter.h"
+
+// Formati dei file di uscita
+enum class OutputFormat {
+    Obj,    // un file OBJ per frame
+    Binary, // un solo file .bake con tutti i frame
+    Both,
+    Vat,    // vertex animation texture della clip, vedi VatWriter
+    Sequence // clip compressa con keyframe e differenze tra frame (.bakeseq), vedi BakeSequence.h
+};
+
+// Opzioni del bake lette dalla riga di comando. I tempi sono espressi in tick dell'animazione.
+struct BakeSettings {
+    std::string inputPath = "Mesh/AnimatedSkeletalMeshASCII.fbx";
+    std::string outputPath = "Mesh/OutputMesh.obj";
+
+    // Se non vuoto, la scena importata viene salvata in questo file e riletta dai bake successivi
+    // finche' il file di ingresso e le opzioni di importazione non cambiano
+    std::string sceneCachePath;
+    bool syntheticInput = false; // con --synthetic la scena viene generata invece di essere importata da inputPath
+    SyntheticSceneSettings syntheticScene;
+    OutputFormat outputFormat = OutputFormat::Obj;
+    BakeFileEncoding binaryEncoding; // codifica di posizioni e normali nel file .bake
+    VatFormat vatFormat = VatFormat::Float;
+    bool vatNormals = false;
+    unsigned int keyframeInterval = 16; // frame per keyframe nel file .bakeseq
+    unsigned int verifyFrames = 0;      // frame del file .bakeseq riletti e confrontati dopo il bake
+    int objPrecision = 0; // cifre significative dei float nell'OBJ, zero: la piu' corta che li rilegge esatti
+    unsigned int animationIndex = 0;
+
+    // Senza --end, --step o --fps viene calcolato il solo frame a startTime, tranne che per le VAT
+    // e i file .bakeseq che contengono sempre la clip fino alla fine
+    bool bakeRange = false;
+    float startTime = 0.0f;
+    float endTime = -1.0f;        // negativo: fino alla durata dell'animazione
+    float timeStep = 0.0f;        // zero: un frame per tick
+    float framesPerSecond = 0.0f; // se positivo il passo viene ricavato da aiAnimation::mTicksPerSecond
+
+    unsigned int numThreads = 0;  // thread per il calcolo dei frame, zero: tutti i core
+
+    // Con piu' frame i canali vengono ricampionati sugli istanti del bake prima di calcolare le pose;
+    // con trackCachePath le tracce vengono rilette da quel file se corrispondono, altrimenti salvate li'
+    bool sampledTracks = true;
+    std::string trackCachePath;
+
+    // Con un solo frame i thread si dividono i vertici delle mesh con almeno parallelSkinningThreshold vertici
+    SkinningMode skinningMode = SkinningMode::Automatic;
+    unsigned int parallelSkinningThreshold = 200000;
+
+    // Kernel SIMD del ciclo di skinning, di default il migliore supportato dalla CPU
+    SkinningKernel skinningKernel = SkinningKernel::Automatic;
+
+    // Se non vuoto, le fasi del bake vengono misurate e salvate in questo file come trace di Chrome
+    std::string profilePath;
+};
+
+// Restituisce false e stampa l'errore se gli argomenti non sono validi
+bool parseBakeSettings(int argc, char* argv[], BakeSettings& settings);
+
+// Numero massimo di frame di un bake
+static const unsigned int MAX_BAKE_FRAMES = 10000000;
+
+// Restituisce false e stampa l'errore se l'intervallo non contiene frame o ne contiene piu' di MAX_BAKE_FRAMES
+bool computeFrameTimes(const BakeSettings& settings, const aiAnimation* animation, std::vector<float>& frameTimes);
+
+// Con piu' frame aggiunge l'indice del frame al nome del file: OutputMesh.obj -> OutputMesh_0001.obj
+std::string frameOutputPath(const std::string& outputPath, unsigned int frameIndex, size_t numFrames);
+
+// Percorso di uscita senza estensione, a cui i formati con piu' file aggiungono i propri suffissi
+std::string outputBasePath(const std::string& outputPath);
+
+// Percorso del file binario: l'estensione di outputPath diventa .bake, OutputMesh.obj -> OutputMesh.bake
+std::string binaryOutputPath(const std::string& outputPath);
+
+// Percorso del file compresso: l'estensione di outputPath diventa .bakeseq
+std::string sequenceOutputPath(const std::string& outputPath);
@@ -0,0 +1,415 @@
+// Benchmark delle fasi del bake (progetto BakingBenchmark): microbenchmark di ricerca e interpolazione
+// delle chiavi, gerarchia, skinning e scrittura OBJ, e bake completi di uno e piu' frame. I risultati
+// vengono stampati in tabella e, con --json, salvati in un file leggibile dagli script di confronto.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "AnimationBinding.h"
+#include "BakeMesh.h"
+#include "ObjWriter.h"
+#include "Pose.h"
+#include "SampledTracks.h"
+#include "Skeleton.h"
+#include "Skinning.h"
+#include "SyntheticScene.h"
+#include "ThreadPool.h"
+
+// Istanti campionati da ogni iterazione dei microbenchmark delle pose
+static const unsigned int POSE_SAMPLES = 64;
+
+struct BenchmarkOptions {
+    std::string inputPath = "Mesh/AnimatedSkeletalMeshASCII.fbx";
+    bool syntheticInput = false;
+    SyntheticSceneSettings syntheticScene;
+    unsigned int animationIndex = 0;
+    double minTime = 0.5;         // secondi minimi di misura per benchmark
+    unsigned int numFrames = 64;  // frame del bake a piu' frame
+    unsigned int numThreads = 0;  // zero: tutti i core
+    std::string jsonPath;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    const char* unit = "";        // unita' di lavoro: bone, vertex, frame
+    double unitsPerIteration = 0.0;
+    double bytesPerIteration = 0.0; // byte scritti, zero se il benchmark non scrive
+    unsigned int iterations = 0;
+    double nsPerIteration = 0.0;
+
+    double nsPerUnit() const { return nsPerIteration / unitsPerIteration; }
+    double unitsPerSecond() const { return unitsPerIteration * 1e9 / nsPerIteration; }
+    double megabytesPerSecond() const { return bytesPerIteration * 1e3 / nsPerIteration; }
+};
+
+// Scarta i byte scritti contandoli, per misurare la formattazione senza il costo del disco
+class CountingBuffer : public std::streambuf {
+public:
+    uint64_t count = 0;
+
+protected:
+    std::streamsize xsputn(const char*, std::streamsize size) override {
+        count += (uint64_t)size;
+        return size;
+    }
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            count++;
+        }
+        return traits_type::not_eof(c);
+    }
+};
+
+// Impedisce al compilatore di eliminare i calcoli di cui non si usa il risultato
+static volatile float benchmarkSink;
+
+// Ripete function finche' non sono trascorsi almeno minTime secondi, dopo un'esecuzione di riscaldamento.
+// function restituisce i byte scritti dall'iterazione.
+template <typename Function>
+static BenchmarkResult measure(const std::string& name, const char* unit, double unitsPerIteration, double minTime, Function function) {
+    using Clock = std::chrono::steady_clock;
+    function();
+
+    BenchmarkResult result;
+    result.name = name;
+    result.unit = unit;
+    result.unitsPerIteration = unitsPerIteration;
+    double bytes = 0.0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        bytes += (double)function();
+        result.iterations++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minTime);
+
+    result.nsPerIteration = elapsed * 1e9 / result.iterations;
+    result.bytesPerIteration = bytes / result.iterations;
+    return result;
+}
+
+static void printUsage() {
+    std::cout << "Uso: BakingBenchmark [--input file | --synthetic bones=n,vertices=n,...] [--animation indice] [--min-time secondi] [--frames n]" << std::endl;
+    std::cout << "                     [--threads n] [--json file]" << std::endl;
+}
+
+static bool parseBenchmarkOptions(int argc, char* argv[], BenchmarkOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* option = argv[i];
+        if (i + 1 >= argc) {
+            std::cout << "Valore mancante per l'opzione " << option << std::endl;
+            printUsage();
+            return false;
+        }
+        const char* value = argv[++i];
+
+        char* end = nullptr;
+        double number = std::strtod(value, &end);
+        bool isNumber = end != value && *end == '\0' && number >= 0.0;
+        bool valid = true;
+        if (std::strcmp(option, "--input") == 0) {
+            options.inputPath = value;
+        }
+        else if (std::strcmp(option, "--synthetic") == 0) {
+            valid = parseSyntheticSceneSettings(value, options.syntheticScene);
+            options.syntheticInput = true;
+            // Nei risultati la scena generata e' identificata dalla sua specifica
+            options.inputPath = std::string("synthetic:") + value;
+        }
+        else if (std::strcmp(option, "--animation") == 0) {
+            valid = isNumber;
+            options.animationIndex = (unsigned int)number;
+        }
+        else if (std::strcmp(option, "--min-time") == 0) {
+            valid = isNumber && number > 0.0;
+            options.minTime = number;
+        }
+        else if (std::strcmp(option, "--frames") == 0) {
+            valid = isNumber && number >= 1.0;
+            options.numFrames = (unsigned int)number;
+        }
+        else if (std::strcmp(option, "--threads") == 0) {
+            valid = isNumber;
+            options.numThreads = (unsigned int)number;
+        }
+        else if (std::strcmp(option, "--json") == 0) {
+            options.jsonPath = value;
+        }
+        else {
+            std::cout << "Opzione sconosciuta: " << option << std::endl;
+            printUsage();
+            return false;
+        }
+
+        if (!valid) {
+            std::cout << "Valore non valido per l'opzione " << option << ": " << value << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void writeJsonString(std::ostream& output, const std::string& text) {
+    output << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            output << '\\' << c;
+        }
+        else if ((unsigned char)c < ' ') {
+            output << ' ';
+        }
+        else {
+            output << c;
+        }
+    }
+    output << '"';
+}
+
+// JSON non ha inf e nan: per esempio nsPerUnit di una scena senza canali diventa null
+static void writeJsonNumber(std::ostream& output, double value) {
+    if (std::isfinite(value)) {
+        output << value;
+    }
+    else {
+        output << "null";
+    }
+}
+
+static bool writeJson(const std::string& path, const BenchmarkOptions& options, unsigned int numThreads, const std::vector<BenchmarkResult>& results) {
+    std::ofstream output(path);
+    if (!output.is_open()) {
+        return false;
+    }
+    output << std::setprecision(6);
+    output << "{\n  \"input\": ";
+    writeJsonString(output, options.inputPath);
+    output << ",\n  \"threads\": " << numThreads;
+    output << ",\n  \"kernel\": \"" << skinningKernelName(activeSkinningKernel()) << "\"";
+    output << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& result = results[i];
+        output << (i > 0 ? "," : "") << "\n    { \"name\": ";
+        writeJsonString(output, result.name);
+        output << ", \"unit\": \"" << result.unit << "\", \"iterations\": " << result.iterations
+            << ", \"nsPerIteration\": ";
+        writeJsonNumber(output, result.nsPerIteration);
+        output << ", \"nsPerUnit\": ";
+        writeJsonNumber(output, result.nsPerUnit());
+        output << ", \"unitsPerSecond\": ";
+        writeJsonNumber(output, result.unitsPerSecond());
+        output << ", \"megabytesPerSecond\": ";
+        writeJsonNumber(output, result.megabytesPerSecond());
+        output << " }";
+    }
+    output << "\n  ]\n}\n";
+    output.close();
+    return !output.fail();
+}
+
+static void printResults(const std::vector<BenchmarkResult>& results) {
+    std::cout << std::left << std::setw(44) << "benchmark" << std::right << std::setw(10) << "iter"
+        << std::setw(14) << "ns/iter" << std::setw(12) << "ns/unita'" << std::setw(20) << "unita'/s" << std::setw(10) << "MB/s" << std::endl;
+    for (const BenchmarkResult& result : results) {
+        std::cout << std::left << std::setw(44) << result.name << std::right << std::setw(10) << result.iterations
+            << std::fixed << std::setprecision(0) << std::setw(14) << result.nsPerIteration
+            << std::setprecision(2) << std::setw(12) << result.nsPerUnit() << " " << std::left << std::setw(7) << result.unit << std::right
+            << std::setprecision(0) << std::setw(12) << result.unitsPerSecond();
+        if (result.bytesPerIteration > 0.0) {
+            std::cout << std::setprecision(1) << std::setw(10) << result.megabytesPerSecond();
+        }
+        std::cout << std::defaultfloat << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (!parseBenchmarkOptions(argc, argv, options)) {
+        return -1;
+    }
+
+    // Stesse opzioni di importazione del bake
+    Assimp::Importer importer;
+    unsigned int importFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_LimitBoneWeights | aiProcess_PopulateArmatureData;
+    std::unique_ptr<aiScene> syntheticScene;
+    const aiScene* scene = nullptr;
+    if (options.syntheticInput) {
+        syntheticScene = buildSyntheticScene(options.syntheticScene);
+        scene = syntheticScene.get();
+    }
+    else {
+        scene = importer.ReadFile(options.inputPath, importFlags);
+    }
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+        std::cout << "Errore durante il caricamento della mesh skinnata: " << importer.GetErrorString() << std::endl;
+        return -1;
+    }
+    if (options.animationIndex >= scene->mNumAnimations) {
+        std::cout << "La scena non contiene l'animazione " << options.animationIndex << " (animazioni presenti: " << scene->mNumAnimations << ")" << std::endl;
+        return -1;
+    }
+    const aiAnimation* animation = scene->mAnimations[options.animationIndex];
+
+    Skeleton skeleton = buildSkeleton(scene);
+    AnimationBinding binding = buildAnimationBinding(skeleton, animation);
+    std::vector<BakeMesh> meshes(scene->mNumMeshes);
+    std::vector<SkinningData> skinnings(scene->mNumMeshes);
+    unsigned int totalVertices = 0;
+    for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+        meshes[i] = buildBakeMesh(scene->mMeshes[i]);
+        skinnings[i] = buildSkinningData(scene->mMeshes[i], skeleton);
+        totalVertices += meshes[i].numVertices();
+    }
+    std::vector<const aiNodeAnim*> channels;
+    for (const aiNodeAnim* nodeAnim : binding.nodeAnims) {
+        if (nodeAnim) {
+            channels.push_back(nodeAnim);
+        }
+    }
+
+    ThreadPool threadPool(options.numThreads > 0 ? options.numThreads : std::thread::hardware_concurrency());
+    const SkinningKernel defaultKernel = activeSkinningKernel();
+    std::cout << "Scena " << options.inputPath << ": " << skeleton.size() << " nodi, " << channels.size() << " canali, "
+        << meshes.size() << " mesh, " << totalVertices << " vertici; " << threadPool.size() << " thread, kernel "
+        << skinningKernelName(defaultKernel) << std::endl;
+
+    // Istanti distribuiti sull'intera animazione, crescenti come durante il bake
+    std::vector<float> sampleTimes(POSE_SAMPLES);
+    for (unsigned int i = 0; i < POSE_SAMPLES; i++) {
+        sampleTimes[i] = (float)(animation->mDuration * i / (POSE_SAMPLES - 1));
+    }
+
+    std::vector<BenchmarkResult> results;
+
+    // Ricerca delle chiavi e interpolazione di ogni canale, con cursore
+    results.push_back(measure("interpolateTransformation", "bone", (double)channels.size() * POSE_SAMPLES, options.minTime, [&]() {
+        float sum = 0.0f;
+        for (const aiNodeAnim* nodeAnim : channels) {
+            ChannelCursor cursor;
+            for (float time : sampleTimes) {
+                sum += interpolateTransformation(time, nodeAnim, cursor).a4;
+            }
+        }
+        benchmarkSink = sum;
+        return 0;
+    }));
+
+    // Posa dell'intero scheletro dai canali e dalle tracce ricampionate
+    std::vector<aiMatrix4x4> globalTransformations;
+    std::vector<ChannelCursor> cursors;
+    results.push_back(measure("calculateGlobalTransformations", "bone", (double)skeleton.size() * POSE_SAMPLES, options.minTime, [&]() {
+        cursors.assign(skeleton.size(), ChannelCursor());
+        for (float time : sampleTimes) {
+            calculateGlobalTransformations(skeleton, binding, time, 0, globalTransformations, cursors);
+        }
+        benchmarkSink = globalTransformations.back().a4;
+        return 0;
+    }));
+    SampledTracks sampleTimeTracks = sampleTracks(skeleton, binding, sampleTimes, nullptr);
+    results.push_back(measure("calculateGlobalTransformations/sampled", "bone", (double)skeleton.size() * POSE_SAMPLES, options.minTime, [&]() {
+        for (unsigned int frame = 0; frame < POSE_SAMPLES; frame++) {
+            calculateGlobalTransformations(skeleton, sampleTimeTracks, frame, 0, globalTransformations);
+        }
+        benchmarkSink = globalTransformations.back().a4;
+        return 0;
+    }));
+
+    // Skinning di tutte le mesh in una posa a meta' animazione, con ogni kernel supportato
+    calculateGlobalTransformations(skeleton, binding, sampleTimes[POSE_SAMPLES / 2], 0, globalTransformations, cursors);
+    std::vector<SkinnedMesh> skinnedMeshes(meshes.size());
+    auto skinAll = [&](ThreadPool* vertexThreadPool) {
+        for (size_t i = 0; i < meshes.size(); i++) {
+            applyPoseToMesh(meshes[i], skinnings[i], skeleton, globalTransformations, skinnedMeshes[i], vertexThreadPool);
+        }
+        benchmarkSink = skinnedMeshes.empty() || skinnedMeshes[0].positions.empty() ? 0.0f : skinnedMeshes[0].positions.x[0];
+        return 0;
+    };
+    for (SkinningKernel kernel : { SkinningKernel::Scalar, SkinningKernel::Sse41, SkinningKernel::Avx2 }) {
+        if (setSkinningKernel(kernel)) {
+            results.push_back(measure(std::string("applyPoseToMesh/") + skinningKernelName(kernel), "vertex", totalVertices, options.minTime,
+                [&]() { return skinAll(nullptr); }));
+        }
+    }
+    setSkinningKernel(defaultKernel);
+    results.push_back(measure("applyPoseToMesh/parallel", "vertex", totalVertices, options.minTime, [&]() { return skinAll(&threadPool); }));
+
+    // Formattazione OBJ della posa calcolata, senza scrittura su disco
+    for (int precision : { ObjWriter::SHORTEST_PRECISION, 6 }) {
+        std::string name = precision == ObjWriter::SHORTEST_PRECISION ? "ObjWriter::writeMesh/shortest" : "ObjWriter::writeMesh/precision6";
+        results.push_back(measure(name, "vertex", totalVertices, options.minTime, [&]() {
+            CountingBuffer buffer;
+            std::ostream output(&buffer);
+            ObjWriter writer(output, precision);
+            for (size_t i = 0; i < meshes.size(); i++) {
+                writer.writeMesh(meshes[i], skinnedMeshes[i]);
+            }
+            writer.flush();
+            return buffer.count;
+        }));
+    }
+
+    // Bake completi: posa, skinning e OBJ di un frame, con i vertici divisi tra i thread come nel bake di un frame
+    results.push_back(measure("bake/singleFrame", "frame", 1.0, options.minTime, [&]() {
+        // Una cache nuova per iterazione, altrimenti restituirebbe la posa gia' calcolata
+        PoseCache poseCache(skeleton);
+        CountingBuffer buffer;
+        std::ostream output(&buffer);
+        ObjWriter writer(output);
+        for (size_t i = 0; i < meshes.size(); i++) {
+            const std::vector<aiMatrix4x4>& pose = poseCache.evaluate(binding, sampleTimes[POSE_SAMPLES / 2], skinnings[i].armatureIndex);
+            ThreadPool* vertexThreadPool = useParallelSkinning(SkinningMode::Automatic, meshes[i].numVertices(), 200000) ? &threadPool : nullptr;
+            applyPoseToMesh(meshes[i], skinnings[i], skeleton, pose, skinnedMeshes[i], vertexThreadPool);
+            writer.writeMesh(meshes[i], skinnedMeshes[i]);
+        }
+        writer.flush();
+        return buffer.count;
+    }));
+
+    // Piu' frame divisi tra i thread, con il ricampionamento dei canali compreso nel tempo misurato
+    std::vector<float> frameTimes(options.numFrames);
+    for (unsigned int frame = 0; frame < options.numFrames; frame++) {
+        frameTimes[frame] = options.numFrames > 1 ? (float)(animation->mDuration * frame / (options.numFrames - 1)) : 0.0f;
+    }
+    std::vector<std::vector<SkinnedMesh>> threadMeshes(threadPool.size(), std::vector<SkinnedMesh>(meshes.size()));
+    std::vector<uint64_t> threadBytes(threadPool.size());
+    results.push_back(measure("bake/multiFrame", "frame", options.numFrames, options.minTime, [&]() {
+        SampledTracks tracks = sampleTracks(skeleton, binding, frameTimes, &threadPool);
+        std::vector<PoseCache> threadCaches(threadPool.size(), PoseCache(skeleton));
+        std::fill(threadBytes.begin(), threadBytes.end(), 0);
+        threadPool.parallelFor(options.numFrames, 1, [&](unsigned int threadIndex, unsigned int frame) {
+            CountingBuffer buffer;
+            std::ostream output(&buffer);
+            ObjWriter writer(output);
+            for (size_t i = 0; i < meshes.size(); i++) {
+                const std::vector<aiMatrix4x4>& pose = threadCaches[threadIndex].evaluate(tracks, frame, skinnings[i].armatureIndex);
+                applyPoseToMesh(meshes[i], skinnings[i], skeleton, pose, threadMeshes[threadIndex][i], nullptr);
+                writer.writeMesh(meshes[i], threadMeshes[threadIndex][i]);
+            }
+            writer.flush();
+            threadBytes[threadIndex] += buffer.count;
+        });
+        uint64_t bytes = 0;
+        for (uint64_t count : threadBytes) {
+            bytes += count;
+        }
+        return bytes;
+    }));
+
+    printResults(results);
+    if (!options.jsonPath.empty() && !writeJson(options.jsonPath, options, threadPool.size(), results)) {
+        std::cout << "Impossibile scrivere il file " << options.jsonPath << std::endl;
+        return -1;
+    }
+    return 0;
+}
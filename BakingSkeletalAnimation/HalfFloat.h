@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+
+// Conversione tra float e half IEEE 754 (binary16) con arrotondamento al pari piu' vicino.
+// I valori fuori intervallo diventano infinito, i NaN restano NaN.
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Uso previsto della mappatura: con Sequential il sistema operativo legge in anticipo le pagine
+// successive e libera presto quelle gia' lette
+enum class MappedFileAccess {
+    Sequential,
+    Random
+};
+
+// File mappato in memoria in sola lettura (mmap su POSIX, MapViewOfFile su Windows).
+// Le pagine vengono caricate dalla cache del sistema solo quando vengono lette, senza copie in
+// buffer intermedi; la mappatura resta valida finche' l'oggetto non viene chiuso o distrutto.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Restituisce false se il file non esiste o non puo' essere mappato. Un file vuoto viene
+    // aperto con data() nullo
+    bool open(const std::string& path, MappedFileAccess access = MappedFileAccess::Sequential);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const unsigned char* data() const { return mappedData; }
+    size_t size() const { return mappedSize; }
+
+private:
+    const unsigned char* mappedData = nullptr;
+    size_t mappedSize = 0;
+    bool opened = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
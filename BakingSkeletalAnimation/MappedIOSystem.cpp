@@ -0,0 +1,72 @@
+#include "MappedIOSystem.h"
+
+#include <cstring>
+#include <utility>
+
+MappedIOStream::MappedIOStream(MappedFile&& file) : file(std::move(file)) {
+}
+
+size_t MappedIOStream::Read(void* buffer, size_t size, size_t count) {
+    // Come fread restituisce il numero di elementi completi letti
+    if (size == 0 || count == 0) {
+        return 0;
+    }
+    size_t available = (file.size() - position) / size;
+    size_t numElements = count < available ? count : available;
+    if (numElements > 0) {
+        std::memcpy(buffer, file.data() + position, numElements * size);
+        position += numElements * size;
+    }
+    return numElements;
+}
+
+size_t MappedIOStream::Write(const void*, size_t, size_t) {
+    return 0;
+}
+
+aiReturn MappedIOStream::Seek(size_t offset, aiOrigin origin) {
+    size_t target = 0;
+    switch (origin) {
+    case aiOrigin_SET:
+        target = offset;
+        break;
+    case aiOrigin_CUR:
+        target = position + offset;
+        break;
+    case aiOrigin_END:
+        // Come negli stream di Assimp, l'offset si conta a ritroso dalla fine del file
+        if (offset > file.size()) {
+            return aiReturn_FAILURE;
+        }
+        target = file.size() - offset;
+        break;
+    default:
+        return aiReturn_FAILURE;
+    }
+    if (target > file.size()) {
+        return aiReturn_FAILURE;
+    }
+    position = target;
+    return aiReturn_SUCCESS;
+}
+
+size_t MappedIOStream::Tell() const {
+    return position;
+}
+
+size_t MappedIOStream::FileSize() const {
+    return file.size();
+}
+
+void MappedIOStream::Flush() {
+}
+
+Assimp::IOStream* MappedIOSystem::Open(const char* path, const char* mode) {
+    if (std::strchr(mode, 'r') && !std::strchr(mode, '+')) {
+        MappedFile file;
+        if (file.open(path, MappedFileAccess::Sequential)) {
+            return new MappedIOStream(std::move(file));
+        }
+    }
+    return DefaultIOSystem::Open(path, mode);
+}
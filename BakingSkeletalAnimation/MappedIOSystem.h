@@ -0,0 +1,32 @@
+#pragma once
+
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/IOStream.hpp>
+
+#include "MappedFile.h"
+
+// Stream di Assimp che legge da un file mappato in memoria: Read copia direttamente dalle pagine
+// mappate nel buffer dell'importer, senza passare dal buffer di stdio
+class MappedIOStream : public Assimp::IOStream {
+public:
+    explicit MappedIOStream(MappedFile&& file);
+
+    size_t Read(void* buffer, size_t size, size_t count) override;
+    size_t Write(const void* buffer, size_t size, size_t count) override;
+    aiReturn Seek(size_t offset, aiOrigin origin) override;
+    size_t Tell() const override;
+    size_t FileSize() const override;
+    void Flush() override;
+
+private:
+    MappedFile file;
+    size_t position = 0;
+};
+
+// IOSystem da assegnare all'importer con SetIOHandler: tutti i file aperti in lettura (il modello e gli
+// eventuali file esterni che referenzia) vengono mappati in memoria con accesso sequenziale. I file aperti
+// in scrittura e quelli che non possono essere mappati passano dall'implementazione predefinita.
+class MappedIOSystem : public Assimp::DefaultIOSystem {
+public:
+    Assimp::IOStream* Open(const char* path, const char* mode = "rb") override;
+};
@@ -0,0 +1,130 @@
+#include "ObjWriter.h"
+
+#include <algorithm>
+#include <charconv>
+
+// Dimensione del buffer: il flusso riceve una write ogni OBJ_BUFFER_SIZE byte
+static const size_t OBJ_BUFFER_SIZE = 1 << 20;
+
+// Spazio massimo occupato da un float (segno, 17 cifre, punto, esponente) e da una riga OBJ
+static const int MAX_PRECISION = 17;
+static const size_t MAX_FLOAT_CHARS = 32;
+static const size_t MAX_LINE_CHARS = 4 * MAX_FLOAT_CHARS;
+
+ObjWriter::ObjWriter(std::ostream& output, int precision)
+    : output(output), precision(std::min(std::max(precision, 0), MAX_PRECISION)), buffer(OBJ_BUFFER_SIZE) {
+}
+
+ObjWriter::~ObjWriter() {
+    flush();
+}
+
+void ObjWriter::writeMesh(const BakeMesh& mesh, const SkinnedMesh& skinnedMesh) {
+    std::string name = mesh.name.empty() ? "mesh_" + std::to_string(numMeshes) : mesh.name;
+    writeName('o', name);
+    writeName('g', name);
+
+    const VertexStream& positions = skinnedMesh.positions;
+    for (unsigned int i = 0; i < mesh.numVertices(); i++) {
+        reserve(MAX_LINE_CHARS);
+        buffer[used++] = 'v';
+        writeFloat(positions.x[i]);
+        writeFloat(positions.y[i]);
+        writeFloat(positions.z[i]);
+        buffer[used++] = '\n';
+    }
+
+    const bool hasTexCoords = !mesh.texCoordsU.empty();
+    for (unsigned int i = 0; hasTexCoords && i < mesh.numVertices(); i++) {
+        reserve(MAX_LINE_CHARS);
+        buffer[used++] = 'v';
+        buffer[used++] = 't';
+        writeFloat(mesh.texCoordsU[i]);
+        writeFloat(mesh.texCoordsV[i]);
+        buffer[used++] = '\n';
+    }
+
+    const VertexStream& normals = skinnedMesh.normals;
+    const bool hasNormals = !normals.empty();
+    for (unsigned int i = 0; hasNormals && i < mesh.numVertices(); i++) {
+        reserve(MAX_LINE_CHARS);
+        buffer[used++] = 'v';
+        buffer[used++] = 'n';
+        writeFloat(normals.x[i]);
+        writeFloat(normals.y[i]);
+        writeFloat(normals.z[i]);
+        buffer[used++] = '\n';
+    }
+
+    const uint32_t* indices = mesh.indices.data();
+    for (unsigned int i = 0; i < mesh.numTriangles(); i++) {
+        reserve(MAX_LINE_CHARS);
+        buffer[used++] = 'f';
+        writeFaceVertex(indices[i * 3], hasTexCoords, hasNormals);
+        writeFaceVertex(indices[i * 3 + 1], hasTexCoords, hasNormals);
+        writeFaceVertex(indices[i * 3 + 2], hasTexCoords, hasNormals);
+        buffer[used++] = '\n';
+    }
+
+    numMeshes++;
+    vertexOffset += mesh.numVertices();
+    texCoordOffset += hasTexCoords ? mesh.numVertices() : 0;
+    normalOffset += hasNormals ? mesh.numVertices() : 0;
+}
+
+bool ObjWriter::flush() {
+    if (used > 0) {
+        output.write(buffer.data(), (std::streamsize)used);
+        used = 0;
+    }
+    return !output.fail();
+}
+
+void ObjWriter::reserve(size_t size) {
+    if (used + size > buffer.size()) {
+        flush();
+    }
+}
+
+// Ogni valore e' preceduto da uno spazio, che lo separa dal tag o dal valore precedente
+void ObjWriter::writeFloat(float value) {
+    buffer[used++] = ' ';
+    char* first = buffer.data() + used;
+    char* last = first + MAX_FLOAT_CHARS;
+    std::to_chars_result result = precision == SHORTEST_PRECISION
+        ? std::to_chars(first, last, value)
+        : std::to_chars(first, last, value, std::chars_format::general, precision);
+    used = result.ptr - buffer.data();
+}
+
+// Gli spazi separerebbero il nome in piu' parole, per cui vengono sostituiti
+void ObjWriter::writeName(char tag, const std::string& name) {
+    reserve(name.size() + 3);
+    buffer[used++] = tag;
+    buffer[used++] = ' ';
+    for (char c : name) {
+        buffer[used++] = (unsigned char)c <= ' ' ? '_' : c;
+    }
+    buffer[used++] = '\n';
+}
+
+void ObjWriter::writeIndex(uint32_t value) {
+    char* first = buffer.data() + used;
+    used = std::to_chars(first, first + MAX_FLOAT_CHARS, value).ptr - buffer.data();
+}
+
+// Gli indici OBJ partono da 1 e sono globali al file, separatamente per v, vt e vn
+void ObjWriter::writeFaceVertex(uint32_t index, bool hasTexCoords, bool hasNormals) {
+    buffer[used++] = ' ';
+    writeIndex(index + vertexOffset + 1);
+    if (hasTexCoords || hasNormals) {
+        buffer[used++] = '/';
+    }
+    if (hasTexCoords) {
+        writeIndex(index + texCoordOffset + 1);
+    }
+    if (hasNormals) {
+        buffer[used++] = '/';
+        writeIndex(index + normalOffset + 1);
+    }
+}
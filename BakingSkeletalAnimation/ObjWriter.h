@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "BakeMesh.h"
+#include "Skinning.h"
+
+// Scrittura OBJ bufferizzata: il testo viene formattato con std::to_chars in un buffer in memoria
+// e passato al flusso di uscita con poche write di grandi dimensioni, senza flush per riga.
+// Le mesh di una scena vengono scritte una dopo l'altra nello stesso file, ognuna nel proprio
+// oggetto e gruppo (o/g), con gli indici delle facce spostati dei vertici delle mesh precedenti.
+// Normali (vn) della posa e coordinate UV (vt) vengono scritte quando la mesh le possiede e
+// le facce le indicizzano nella forma v/vt/vn, v//vn o v/vt.
+class ObjWriter {
+public:
+    // Cifre significative dei float come la precisione di iostream; SHORTEST_PRECISION usa la
+    // rappresentazione piu' corta che riletta restituisce lo stesso float
+    static constexpr int SHORTEST_PRECISION = 0;
+
+    explicit ObjWriter(std::ostream& output, int precision = SHORTEST_PRECISION);
+    ~ObjWriter();
+
+    ObjWriter(const ObjWriter&) = delete;
+    ObjWriter& operator=(const ObjWriter&) = delete;
+
+    // Aggiunge la mesh al file; il nome dell'oggetto e' quello della mesh o mesh_<indice> se vuoto
+    void writeMesh(const BakeMesh& mesh, const SkinnedMesh& skinnedMesh);
+
+    // Svuota il buffer nel flusso; restituisce false se la scrittura e' fallita
+    bool flush();
+
+private:
+    void reserve(size_t size);
+    void writeFloat(float value);
+    void writeIndex(uint32_t value);
+    void writeFaceVertex(uint32_t index, bool hasTexCoords, bool hasNormals);
+    void writeName(char tag, const std::string& name);
+
+    std::ostream& output;
+    int precision;
+    std::vector<char> buffer;
+    size_t used = 0;
+    unsigned int numMeshes = 0;   // mesh gia' scritte
+    uint32_t vertexOffset = 0;    // vertici gia' scritti, da sommare agli indici delle facce
+    uint32_t texCoordOffset = 0;  // come vertexOffset per le righe vt
+    uint32_t normalOffset = 0;    // come vertexOffset per le righe vn
+};
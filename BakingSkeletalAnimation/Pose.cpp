@@ -0,0 +1,196 @@
+#include "Pose.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "Profiler.h"
+
+// Numero massimo di intervalli che il cursore scorre linearmente prima di passare alla ricerca binaria
+static const unsigned int CURSOR_LINEAR_STEPS = 4;
+
+// Restituisce l'indice i dell'intervallo di chiavi [i, i + 1] che contiene animationTime, limitato a [0, numKeys - 2].
+// Con tempi crescenti, come durante il bake di una sequenza, la ricerca riparte dall'ultimo intervallo
+// trovato dal cursore; negli altri casi si usa la ricerca binaria.
+template <typename KeyType>
+static unsigned int findKeyIndex(const KeyType* keys, unsigned int numKeys, float animationTime, unsigned int& cursor) {
+    assert(numKeys >= 2);
+    const unsigned int lastInterval = numKeys - 2;
+
+    unsigned int index = std::min(cursor, lastInterval);
+    if (keys[index].mTime <= animationTime) {
+        for (unsigned int step = 0; step < CURSOR_LINEAR_STEPS; step++) {
+            if (index == lastInterval || animationTime < keys[index + 1].mTime) {
+                cursor = index;
+                return index;
+            }
+            index++;
+        }
+    }
+
+    const KeyType* nextKey = std::upper_bound(keys + 1, keys + lastInterval + 1, animationTime,
+        [](float time, const KeyType& key) { return time < key.mTime; });
+    cursor = (unsigned int)(nextKey - keys) - 1;
+    return cursor;
+}
+
+// Fattore di interpolazione tra la chiave frameIndex e la successiva, limitato a [0, 1]
+// in modo che prima della prima chiave e dopo l'ultima venga mantenuto il valore estremo
+template <typename KeyType>
+static float interpolationFactor(const KeyType* keys, unsigned int frameIndex, float animationTime) {
+    float deltaTime = (float)(keys[frameIndex + 1].mTime - keys[frameIndex].mTime);
+    if (deltaTime <= 0.0f) {
+        return 0.0f;
+    }
+    float factor = (animationTime - (float)keys[frameIndex].mTime) / deltaTime;
+    return std::min(std::max(factor, 0.0f), 1.0f);
+}
+
+aiMatrix4x4 interpolateTransformation(float animationTime, const aiNodeAnim* nodeAnim) {
+    ChannelCursor cursor;
+    return interpolateTransformation(animationTime, nodeAnim, cursor);
+}
+
+aiMatrix4x4 interpolateTransformation(float animationTime, const aiNodeAnim* nodeAnim, ChannelCursor& cursor) {
+    // Una componente senza chiavi non contribuisce: resta l'identita'
+    aiMatrix4x4 transformation;
+
+    // Interpolazione della traslazione
+    if (nodeAnim->mNumPositionKeys == 1) {
+        transformation = aiMatrix4x4(); // Inizializza come matrice identit
+        transformation.a4 = nodeAnim->mPositionKeys[0].mValue.x;
+        transformation.b4 = nodeAnim->mPositionKeys[0].mValue.y;
+        transformation.c4 = nodeAnim->mPositionKeys[0].mValue.z;
+    }
+    else if (nodeAnim->mNumPositionKeys > 1) {
+        unsigned int frameIndex = findKeyIndex(nodeAnim->mPositionKeys, nodeAnim->mNumPositionKeys, animationTime, cursor.positionKey);
+        unsigned int nextFrameIndex = frameIndex + 1;
+        float factor = interpolationFactor(nodeAnim->mPositionKeys, frameIndex, animationTime);
+        const aiVector3D& startPosition = nodeAnim->mPositionKeys[frameIndex].mValue;
+        const aiVector3D& endPosition = nodeAnim->mPositionKeys[nextFrameIndex].mValue;
+        aiVector3D interpolatedPosition = startPosition + factor * (endPosition - startPosition);
+
+        transformation = aiMatrix4x4(); // Inizializza come matrice identit
+        transformation.a4 = interpolatedPosition.x;
+        transformation.b4 = interpolatedPosition.y;
+        transformation.c4 = interpolatedPosition.z;
+    }
+
+    // Interpolazione della rotazione
+    if (nodeAnim->mNumRotationKeys == 1) {
+        aiQuaternion rotationQ = nodeAnim->mRotationKeys[0].mValue;
+        aiMatrix4x4 rotationMatrix = aiMatrix4x4(rotationQ.GetMatrix());
+        transformation *= rotationMatrix;
+    }
+    else if (nodeAnim->mNumRotationKeys > 1) {
+        unsigned int frameIndex = findKeyIndex(nodeAnim->mRotationKeys, nodeAnim->mNumRotationKeys, animationTime, cursor.rotationKey);
+        unsigned int nextFrameIndex = frameIndex + 1;
+        float factor = interpolationFactor(nodeAnim->mRotationKeys, frameIndex, animationTime);
+        const aiQuaternion& startRotationQ = nodeAnim->mRotationKeys[frameIndex].mValue;
+        const aiQuaternion& endRotationQ = nodeAnim->mRotationKeys[nextFrameIndex].mValue;
+        aiQuaternion interpolatedRotationQ;
+        aiQuaternion::Interpolate(interpolatedRotationQ, startRotationQ, endRotationQ, factor);
+        interpolatedRotationQ.Normalize();
+        aiMatrix4x4 rotationMatrix = aiMatrix4x4(interpolatedRotationQ.GetMatrix());
+        transformation *= rotationMatrix;
+    }
+
+    // Interpolazione dello scaling
+    if (nodeAnim->mNumScalingKeys == 1) {
+        aiVector3D scale = nodeAnim->mScalingKeys[0].mValue;
+        aiMatrix4x4 scalingMatrix;
+        scalingMatrix.a1 = scale.x; scalingMatrix.a2 = 0.0f; scalingMatrix.a3 = 0.0f; scalingMatrix.a4 = 0.0f;
+        scalingMatrix.b1 = 0.0f; scalingMatrix.b2 = scale.y; scalingMatrix.b3 = 0.0f; scalingMatrix.b4 = 0.0f;
+        scalingMatrix.c1 = 0.0f; scalingMatrix.c2 = 0.0f; scalingMatrix.c3 = scale.z; scalingMatrix.c4 = 0.0f;
+        scalingMatrix.d1 = 0.0f; scalingMatrix.d2 = 0.0f; scalingMatrix.d3 = 0.0f; scalingMatrix.d4 = 1.0f;
+        transformation *= scalingMatrix;
+    }
+    else if (nodeAnim->mNumScalingKeys > 1) {
+        unsigned int frameIndex = findKeyIndex(nodeAnim->mScalingKeys, nodeAnim->mNumScalingKeys, animationTime, cursor.scalingKey);
+        unsigned int nextFrameIndex = frameIndex + 1;
+        float factor = interpolationFactor(nodeAnim->mScalingKeys, frameIndex, animationTime);
+        const aiVector3D& startScaling = nodeAnim->mScalingKeys[frameIndex].mValue;
+        const aiVector3D& endScaling = nodeAnim->mScalingKeys[nextFrameIndex].mValue;
+        aiVector3D interpolatedScaling = startScaling + factor * (endScaling - startScaling);
+        aiMatrix4x4 scalingMatrix;
+        scalingMatrix.a1 = interpolatedScaling.x; scalingMatrix.a2 = 0.0f; scalingMatrix.a3 = 0.0f; scalingMatrix.a4 = 0.0f;
+        scalingMatrix.b1 = 0.0f; scalingMatrix.b2 = interpolatedScaling.y; scalingMatrix.b3 = 0.0f; scalingMatrix.b4 = 0.0f;
+        scalingMatrix.c1 = 0.0f; scalingMatrix.c2 = 0.0f; scalingMatrix.c3 = interpolatedScaling.z; scalingMatrix.c4 = 0.0f;
+        scalingMatrix.d1 = 0.0f; scalingMatrix.d2 = 0.0f; scalingMatrix.d3 = 0.0f; scalingMatrix.d4 = 1.0f;
+        transformation *= scalingMatrix;
+    }
+
+    return transformation;
+}
+
+static aiMatrix4x4 calculateLocalTransformation(const Skeleton& skeleton, const AnimationBinding& binding, float animationTime, unsigned int nodeIndex, std::vector<ChannelCursor>& cursors) {
+    const aiNodeAnim* nodeAnim = binding.nodeAnims[nodeIndex];
+    return nodeAnim ? interpolateTransformation(animationTime, nodeAnim, cursors[nodeIndex]) : skeleton.localTransformations[nodeIndex];
+}
+
+static aiMatrix4x4 calculateLocalTransformation(const Skeleton& skeleton, const SampledTracks& tracks, unsigned int frame, unsigned int nodeIndex) {
+    int track = tracks.nodeTracks[nodeIndex];
+    return track >= 0 ? tracks.localTransformation(frame, (unsigned int)track) : skeleton.localTransformations[nodeIndex];
+}
+
+// Visita del sottoalbero comune alle due sorgenti delle trasformazioni locali
+template <typename LocalTransformation>
+static void accumulateGlobalTransformations(const Skeleton& skeleton, unsigned int rootIndex, std::vector<aiMatrix4x4>& globalTransformations, LocalTransformation localTransformation) {
+    globalTransformations.resize(skeleton.size());
+
+    // Trasformazione accumulata degli antenati della radice del sottoalbero
+    aiMatrix4x4 parentTransformation;
+    for (int ancestorIndex = skeleton.parentIndices[rootIndex]; ancestorIndex != Skeleton::NO_PARENT; ancestorIndex = skeleton.parentIndices[ancestorIndex]) {
+        parentTransformation = localTransformation((unsigned int)ancestorIndex) * parentTransformation;
+    }
+    globalTransformations[rootIndex] = parentTransformation * localTransformation(rootIndex);
+
+    // I padri precedono i figli, quindi basta un solo ciclo in avanti sui nodi del sottoalbero
+    for (unsigned int i = rootIndex + 1; i < skeleton.subtreeEnds[rootIndex]; i++) {
+        globalTransformations[i] = globalTransformations[skeleton.parentIndices[i]] * localTransformation(i);
+    }
+}
+
+void calculateGlobalTransformations(const Skeleton& skeleton, const AnimationBinding& binding, float animationTime, unsigned int rootIndex, std::vector<aiMatrix4x4>& globalTransformations, std::vector<ChannelCursor>& cursors) {
+    cursors.resize(skeleton.size());
+    accumulateGlobalTransformations(skeleton, rootIndex, globalTransformations, [&](unsigned int nodeIndex) {
+        return calculateLocalTransformation(skeleton, binding, animationTime, nodeIndex, cursors);
+    });
+}
+
+void calculateGlobalTransformations(const Skeleton& skeleton, const SampledTracks& tracks, unsigned int frame, unsigned int rootIndex, std::vector<aiMatrix4x4>& globalTransformations) {
+    accumulateGlobalTransformations(skeleton, rootIndex, globalTransformations, [&](unsigned int nodeIndex) {
+        return calculateLocalTransformation(skeleton, tracks, frame, nodeIndex);
+    });
+}
+
+PoseCache::PoseCache(const Skeleton& skeleton) : skeleton(skeleton) {
+}
+
+const std::vector<aiMatrix4x4>& PoseCache::evaluate(const AnimationBinding& binding, float animationTime, unsigned int armatureIndex) {
+    CachedPose& pose = poses[armatureIndex];
+    if (pose.tracks || pose.binding != &binding || pose.animationTime != animationTime) {
+        PROFILE_SCOPE("pose");
+        // I cursori si riferiscono ai canali dell'animazione precedente
+        if (pose.binding != &binding) {
+            pose.cursors.assign(skeleton.size(), ChannelCursor());
+        }
+        calculateGlobalTransformations(skeleton, binding, animationTime, armatureIndex, pose.globalTransformations, pose.cursors);
+        pose.binding = &binding;
+        pose.animationTime = animationTime;
+        pose.tracks = nullptr;
+    }
+    return pose.globalTransformations;
+}
+
+const std::vector<aiMatrix4x4>& PoseCache::evaluate(const SampledTracks& tracks, unsigned int frame, unsigned int armatureIndex) {
+    CachedPose& pose = poses[armatureIndex];
+    if (pose.tracks != &tracks || pose.frame != frame) {
+        PROFILE_SCOPE("pose");
+        calculateGlobalTransformations(skeleton, tracks, frame, armatureIndex, pose.globalTransformations);
+        pose.tracks = &tracks;
+        pose.frame = frame;
+        // I cursori non seguono piu' l'ultima posa calcolata dai canali
+        pose.binding = nullptr;
+    }
+    return pose.globalTransformations;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <assimp/anim.h>
+#include <assimp/matrix4x4.h>
+
+#include "AnimationBinding.h"
+#include "SampledTracks.h"
+#include "Skeleton.h"
+
+// Cursore di lettura di un canale: ultimo intervallo di chiavi trovato per posizione, rotazione e scala.
+// Quando i tempi richiesti crescono la ricerca della chiave riparte da qui invece che dalla prima chiave.
+struct ChannelCursor {
+    unsigned int positionKey = 0;
+    unsigned int rotationKey = 0;
+    unsigned int scalingKey = 0;
+};
+
+aiMatrix4x4 interpolateTransformation(float animationTime, const aiNodeAnim* nodeAnim);
+aiMatrix4x4 interpolateTransformation(float animationTime, const aiNodeAnim* nodeAnim, ChannelCursor& cursor);
+
+// Calcola le trasformazioni globali dei nodi del sottoalbero con radice rootIndex (0 per l'intera scena).
+// Le altre voci di globalTransformations non vengono modificate. cursors contiene un cursore per nodo.
+void calculateGlobalTransformations(const Skeleton& skeleton, const AnimationBinding& binding, float animationTime,
+    unsigned int rootIndex, std::vector<aiMatrix4x4>& globalTransformations, std::vector<ChannelCursor>& cursors);
+
+// Come sopra, leggendo le trasformazioni locali dei nodi animati dal frame delle tracce ricampionate
+void calculateGlobalTransformations(const Skeleton& skeleton, const SampledTracks& tracks, unsigned int frame,
+    unsigned int rootIndex, std::vector<aiMatrix4x4>& globalTransformations);
+
+// Cache delle pose del frame, una per armatura: le mesh legate alla stessa armatura (aiBone::mArmature)
+// e valutate alla stessa coppia (animazione, istante) riusano la posa gia' calcolata.
+class PoseCache {
+public:
+    explicit PoseCache(const Skeleton& skeleton);
+
+    const std::vector<aiMatrix4x4>& evaluate(const AnimationBinding& binding, float animationTime, unsigned int armatureIndex);
+    const std::vector<aiMatrix4x4>& evaluate(const SampledTracks& tracks, unsigned int frame, unsigned int armatureIndex);
+
+private:
+    // La posa e' stata calcolata da binding all'istante animationTime oppure da tracks al frame frame
+    struct CachedPose {
+        const AnimationBinding* binding = nullptr;
+        float animationTime = 0.0f;
+        const SampledTracks* tracks = nullptr;
+        unsigned int frame = 0;
+        std::vector<aiMatrix4x4> globalTransformations;
+        std::vector<ChannelCursor> cursors;
+    };
+
+    const Skeleton& skeleton;
+    std::unordered_map<unsigned int, CachedPose> poses;
+};
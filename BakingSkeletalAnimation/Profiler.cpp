@@ -0,0 +1,153 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct ProfileEvent {
+    const char* name;
+    int64_t startNs;    // dall'attivazione della profilazione
+    int64_t durationNs;
+};
+
+// Eventi di un thread: il thread li aggiunge senza lock, la lettura avviene a registrazione terminata
+struct ThreadEvents {
+    unsigned int threadIndex = 0;
+    std::vector<ProfileEvent> events;
+};
+
+static std::atomic<bool> enabled(false);
+static std::chrono::steady_clock::time_point epoch;
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<ThreadEvents>> registry;
+
+static ThreadEvents& currentThreadEvents() {
+    thread_local ThreadEvents* events = nullptr;
+    if (!events) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(std::unique_ptr<ThreadEvents>(new ThreadEvents()));
+        events = registry.back().get();
+        events->threadIndex = (unsigned int)registry.size() - 1;
+    }
+    return *events;
+}
+
+static int64_t nanosecondsSince(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+bool enableProfiling() {
+#if BAKE_ENABLE_PROFILING
+    epoch = std::chrono::steady_clock::now();
+    // Il thread chiamante e' il primo registrato, quindi il thread 0 del trace
+    currentThreadEvents();
+    enabled.store(true, std::memory_order_relaxed);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool profilingEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+ProfileScope::ProfileScope(const char* name) : name(name) {
+    if (enabled.load(std::memory_order_relaxed)) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+ProfileScope::~ProfileScope() {
+    if (enabled.load(std::memory_order_relaxed)) {
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        currentThreadEvents().events.push_back({ name, nanosecondsSince(epoch, start), nanosecondsSince(start, end) });
+    }
+}
+
+static void writeJsonString(std::ostream& output, const char* text) {
+    output << '"';
+    for (; *text != '\0'; text++) {
+        if (*text == '"' || *text == '\\') {
+            output << '\\' << *text;
+        }
+        else if ((unsigned char)*text < ' ') {
+            output << ' ';
+        }
+        else {
+            output << *text;
+        }
+    }
+    output << '"';
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::ofstream output(path);
+    if (!output.is_open()) {
+        return false;
+    }
+
+    // Eventi completi ("ph": "X") con tempi in microsecondi, piu' il nome di ogni thread
+    output << std::fixed << std::setprecision(3);
+    output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const std::unique_ptr<ThreadEvents>& thread : registry) {
+        output << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->threadIndex
+            << ",\"args\":{\"name\":\"" << (thread->threadIndex == 0 ? "main" : "worker ");
+        if (thread->threadIndex > 0) {
+            output << thread->threadIndex;
+        }
+        output << "\"}}";
+        first = false;
+        for (const ProfileEvent& event : thread->events) {
+            output << ",\n{\"name\":";
+            writeJsonString(output, event.name);
+            output << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->threadIndex
+                << ",\"ts\":" << event.startNs / 1000.0 << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+        }
+    }
+    output << "\n]}\n";
+    output.close();
+    return !output.fail();
+}
+
+void printProfileSummary(std::ostream& output) {
+    struct StageTotals {
+        uint64_t calls = 0;
+        int64_t totalNs = 0;
+        int64_t maximumNs = 0;
+    };
+    std::map<std::string, StageTotals> stages;
+    for (const std::unique_ptr<ThreadEvents>& thread : registry) {
+        for (const ProfileEvent& event : thread->events) {
+            StageTotals& stage = stages[event.name];
+            stage.calls++;
+            stage.totalNs += event.durationNs;
+            stage.maximumNs = std::max(stage.maximumNs, event.durationNs);
+        }
+    }
+
+    // Fasi in ordine di tempo totale; con piu' thread il totale somma il tempo di tutti i thread
+    std::vector<std::pair<std::string, StageTotals>> sorted(stages.begin(), stages.end());
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, StageTotals>& a, const std::pair<std::string, StageTotals>& b) {
+        return a.second.totalNs > b.second.totalNs;
+    });
+    std::ios::fmtflags flags = output.flags();
+    std::streamsize precision = output.precision();
+    output << std::left << std::setw(24) << "Fase" << std::right << std::setw(12) << "Chiamate" << std::setw(14) << "Totale ms"
+        << std::setw(14) << "Media us" << std::setw(14) << "Max us" << std::endl;
+    output << std::fixed;
+    for (const std::pair<std::string, StageTotals>& stage : sorted) {
+        output << std::left << std::setw(24) << stage.first << std::right << std::setw(12) << stage.second.calls
+            << std::setprecision(2) << std::setw(14) << stage.second.totalNs / 1e6
+            << std::setw(14) << stage.second.totalNs / 1e3 / stage.second.calls
+            << std::setw(14) << stage.second.maximumNs / 1e3 << std::endl;
+    }
+    output.flags(flags);
+    output.precision(precision);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Misura delle fasi del bake con timer di scope. Ogni PROFILE_SCOPE("nome") registra inizio e durata
+// dello scope nel buffer del thread corrente, senza lock; al termine gli eventi vengono salvati nel
+// formato JSON dei trace event di Chrome (about://tracing, Perfetto) e riassunti in una tabella.
+// Finche' la profilazione non e' attivata uno scope costa la lettura di un flag. Compilando con
+// BAKE_ENABLE_PROFILING=0 gli scope spariscono del tutto.
+#ifndef BAKE_ENABLE_PROFILING
+#define BAKE_ENABLE_PROFILING 1
+#endif
+
+#if BAKE_ENABLE_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
+
+// Attiva la registrazione degli eventi; va chiamata prima di avviare i thread. Restituisce false
+// se la profilazione e' stata esclusa dalla compilazione.
+bool enableProfiling();
+bool profilingEnabled();
+
+// Da chiamare quando nessun thread sta registrando eventi, per esempio a bake terminato
+bool writeChromeTrace(const std::string& path);
+void printProfileSummary(std::ostream& output);
+
+class ProfileScope {
+public:
+    // name deve restare valido fino alla scrittura del trace: di norma una stringa letterale
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+};
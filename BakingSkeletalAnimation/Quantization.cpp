@@ -0,0 +1,76 @@
+#include "Quantization.h"
+
+#include <algorithm>
+#include <cmath>
+
+uint16_t quantizeUnorm16(float value, float minimum, float extent) {
+    if (extent <= 0.0f) {
+        return 0;
+    }
+    float normalized = std::min(std::max((value - minimum) / extent, 0.0f), 1.0f);
+    return (uint16_t)std::lround(normalized * 65535.0f);
+}
+
+float dequantizeUnorm16(uint16_t value, float minimum, float extent) {
+    return minimum + value / 65535.0f * extent;
+}
+
+int32_t quantizeSnorm(float value, int bits) {
+    const float scale = (float)((1 << (bits - 1)) - 1);
+    return (int32_t)std::lround(std::min(std::max(value, -1.0f), 1.0f) * scale);
+}
+
+float dequantizeSnorm(int32_t value, int bits) {
+    const float scale = (float)((1 << (bits - 1)) - 1);
+    return std::max(value / scale, -1.0f);
+}
+
+static const double RADIANS_TO_DEGREES = 57.295779513082320876798;
+
+static float signNotZero(float value) {
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+void octahedralEncode(float x, float y, float z, float& u, float& v) {
+    float length = std::fabs(x) + std::fabs(y) + std::fabs(z);
+    if (length == 0.0f) {
+        u = 0.0f;
+        v = 0.0f;
+        return;
+    }
+    u = x / length;
+    v = y / length;
+    // L'emisfero inferiore viene ripiegato sui triangoli esterni del quadrato
+    if (z < 0.0f) {
+        float foldedU = (1.0f - std::fabs(v)) * signNotZero(u);
+        float foldedV = (1.0f - std::fabs(u)) * signNotZero(v);
+        u = foldedU;
+        v = foldedV;
+    }
+}
+
+void octahedralDecode(float u, float v, float& x, float& y, float& z) {
+    x = u;
+    y = v;
+    z = 1.0f - std::fabs(u) - std::fabs(v);
+    if (z < 0.0f) {
+        x = (1.0f - std::fabs(v)) * signNotZero(u);
+        y = (1.0f - std::fabs(u)) * signNotZero(v);
+    }
+    float length = std::sqrt(x * x + y * y + z * z);
+    x /= length;
+    y /= length;
+    z /= length;
+}
+
+// atan2 resta preciso anche per angoli piccoli, a differenza di acos del prodotto scalare
+float normalAngleError(float x, float y, float z, float decodedX, float decodedY, float decodedZ) {
+    if (x == 0.0f && y == 0.0f && z == 0.0f) {
+        return 0.0f;
+    }
+    double crossX = (double)y * decodedZ - (double)z * decodedY;
+    double crossY = (double)z * decodedX - (double)x * decodedZ;
+    double crossZ = (double)x * decodedY - (double)y * decodedX;
+    double dot = (double)x * decodedX + (double)y * decodedY + (double)z * decodedZ;
+    return (float)(std::atan2(std::sqrt(crossX * crossX + crossY * crossY + crossZ * crossZ), dot) * RADIANS_TO_DEGREES);
+}
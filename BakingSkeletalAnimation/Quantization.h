@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+// Codifiche compatte di posizioni e normali usate dai formati di uscita
+
+// Valore in [minimum, minimum + extent] su 16 bit senza segno; con extent nullo restituisce 0
+uint16_t quantizeUnorm16(float value, float minimum, float extent);
+float dequantizeUnorm16(uint16_t value, float minimum, float extent);
+
+// Valore in [-1, 1] su un intero con segno di bits bit (8 o 16)
+int32_t quantizeSnorm(float value, int bits);
+float dequantizeSnorm(int32_t value, int bits);
+
+// Mappa ottaedrica di un versore su due componenti in [-1, 1]. Il vettore nullo diventa (0, 0).
+void octahedralEncode(float x, float y, float z, float& u, float& v);
+// Ricostruisce il versore, gia' normalizzato
+void octahedralDecode(float u, float v, float& x, float& y, float& z);
+
+// Angolo in gradi tra una normale e la sua versione ricostruita, che puo' non essere normalizzata; 0 per la normale nulla
+float normalAngleError(float x, float y, float z, float decodedX, float decodedY, float decodedZ);
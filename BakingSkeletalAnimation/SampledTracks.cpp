@@ -0,0 +1,168 @@
+#include "SampledTracks.h"
+
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#include "Pose.h"
+
+static const char SAMPLED_TRACKS_MAGIC[8] = { 'B', 'A', 'K', 'E', 'T', 'R', 'K', '\0' };
+static const uint32_t SAMPLED_TRACKS_VERSION = 1;
+
+struct SampledTracksHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numNodes;
+    uint32_t numTracks;
+    uint32_t numFrames;
+    uint64_t fingerprint;
+};
+static_assert(sizeof(SampledTracksHeader) == 32, "SampledTracksHeader deve occupare 32 byte");
+
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+static const uint64_t FNV_PRIME = 1099511628211ull;
+
+static void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+}
+
+aiMatrix4x4 SampledTracks::localTransformation(unsigned int frame, unsigned int track) const {
+    const float* m = &transforms[((size_t)frame * trackNodes.size() + track) * MATRIX_FLOATS];
+    return aiMatrix4x4(m[0], m[1], m[2], m[3],
+        m[4], m[5], m[6], m[7],
+        m[8], m[9], m[10], m[11],
+        0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+uint64_t computeTracksFingerprint(const Skeleton& skeleton, const AnimationBinding& binding, const std::vector<float>& frameTimes) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (unsigned int i = 0; i < skeleton.size(); i++) {
+        const aiString& name = skeleton.nodes[i]->mName;
+        hashBytes(hash, name.C_Str(), name.length + 1);
+        const aiNodeAnim* nodeAnim = binding.nodeAnims[i];
+        uint32_t numKeys[3] = { 0, 0, 0 };
+        if (nodeAnim) {
+            numKeys[0] = nodeAnim->mNumPositionKeys;
+            numKeys[1] = nodeAnim->mNumRotationKeys;
+            numKeys[2] = nodeAnim->mNumScalingKeys;
+        }
+        hashBytes(hash, numKeys, sizeof(numKeys));
+        // Tempi e valori campo per campo, senza il padding delle strutture delle chiavi
+        for (uint32_t k = 0; k < numKeys[0]; k++) {
+            hashBytes(hash, &nodeAnim->mPositionKeys[k].mTime, sizeof(double));
+            hashBytes(hash, &nodeAnim->mPositionKeys[k].mValue, sizeof(aiVector3D));
+        }
+        for (uint32_t k = 0; k < numKeys[1]; k++) {
+            hashBytes(hash, &nodeAnim->mRotationKeys[k].mTime, sizeof(double));
+            hashBytes(hash, &nodeAnim->mRotationKeys[k].mValue, sizeof(aiQuaternion));
+        }
+        for (uint32_t k = 0; k < numKeys[2]; k++) {
+            hashBytes(hash, &nodeAnim->mScalingKeys[k].mTime, sizeof(double));
+            hashBytes(hash, &nodeAnim->mScalingKeys[k].mValue, sizeof(aiVector3D));
+        }
+    }
+    hashBytes(hash, frameTimes.data(), frameTimes.size() * sizeof(float));
+    return hash;
+}
+
+SampledTracks sampleTracks(const Skeleton& skeleton, const AnimationBinding& binding, const std::vector<float>& frameTimes, ThreadPool* threadPool) {
+    SampledTracks tracks;
+    tracks.numFrames = (unsigned int)frameTimes.size();
+    tracks.nodeTracks.assign(skeleton.size(), -1);
+    for (unsigned int i = 0; i < skeleton.size(); i++) {
+        if (binding.nodeAnims[i]) {
+            tracks.nodeTracks[i] = (int)tracks.trackNodes.size();
+            tracks.trackNodes.push_back(i);
+        }
+    }
+    tracks.transforms.resize((size_t)tracks.numFrames * tracks.trackNodes.size() * SampledTracks::MATRIX_FLOATS);
+    tracks.fingerprint = computeTracksFingerprint(skeleton, binding, frameTimes);
+
+    // Ogni traccia viene campionata per intero da un solo thread, con tempi crescenti per il cursore
+    const size_t numTracks = tracks.trackNodes.size();
+    auto sampleTrack = [&](unsigned int, unsigned int track) {
+        const aiNodeAnim* nodeAnim = binding.nodeAnims[tracks.trackNodes[track]];
+        ChannelCursor cursor;
+        for (unsigned int frame = 0; frame < tracks.numFrames; frame++) {
+            aiMatrix4x4 m = interpolateTransformation(frameTimes[frame], nodeAnim, cursor);
+            float* destination = &tracks.transforms[((size_t)frame * numTracks + track) * SampledTracks::MATRIX_FLOATS];
+            const float rows[SampledTracks::MATRIX_FLOATS] = { m.a1, m.a2, m.a3, m.a4, m.b1, m.b2, m.b3, m.b4, m.c1, m.c2, m.c3, m.c4 };
+            std::memcpy(destination, rows, sizeof(rows));
+        }
+    };
+    if (threadPool) {
+        threadPool->parallelFor((unsigned int)numTracks, 1, sampleTrack);
+    }
+    else {
+        for (unsigned int track = 0; track < numTracks; track++) {
+            sampleTrack(0, track);
+        }
+    }
+    return tracks;
+}
+
+bool saveSampledTracks(const std::string& path, const SampledTracks& tracks) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    SampledTracksHeader header = {};
+    std::memcpy(header.magic, SAMPLED_TRACKS_MAGIC, sizeof(header.magic));
+    header.version = SAMPLED_TRACKS_VERSION;
+    header.numNodes = (uint32_t)tracks.nodeTracks.size();
+    header.numTracks = (uint32_t)tracks.trackNodes.size();
+    header.numFrames = tracks.numFrames;
+    header.fingerprint = tracks.fingerprint;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(tracks.trackNodes.data()), (std::streamsize)(tracks.trackNodes.size() * sizeof(uint32_t)));
+    file.write(reinterpret_cast<const char*>(tracks.transforms.data()), (std::streamsize)(tracks.transforms.size() * sizeof(float)));
+    file.close();
+    return !file.fail();
+}
+
+bool loadSampledTracks(const std::string& path, uint64_t fingerprint, const Skeleton& skeleton, SampledTracks& tracks) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    SampledTracksHeader header = {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, SAMPLED_TRACKS_MAGIC, sizeof(header.magic)) != 0 || header.version != SAMPLED_TRACKS_VERSION
+        || header.fingerprint != fingerprint || header.numNodes != skeleton.size() || header.numTracks > header.numNodes) {
+        return false;
+    }
+    // La dimensione attesa viene verificata prima di allocare le tracce
+    const uint64_t expectedSize = sizeof(header) + (uint64_t)header.numTracks * sizeof(uint32_t)
+        + (uint64_t)header.numFrames * header.numTracks * SampledTracks::MATRIX_FLOATS * sizeof(float);
+    file.seekg(0, std::ios::end);
+    if ((uint64_t)file.tellg() != expectedSize) {
+        return false;
+    }
+    file.seekg(sizeof(header));
+
+    SampledTracks loaded;
+    loaded.numFrames = header.numFrames;
+    loaded.fingerprint = header.fingerprint;
+    loaded.trackNodes.resize(header.numTracks);
+    file.read(reinterpret_cast<char*>(loaded.trackNodes.data()), (std::streamsize)(loaded.trackNodes.size() * sizeof(uint32_t)));
+    loaded.nodeTracks.assign(header.numNodes, -1);
+    for (unsigned int track = 0; track < header.numTracks; track++) {
+        if (!file || loaded.trackNodes[track] >= header.numNodes || loaded.nodeTracks[loaded.trackNodes[track]] >= 0) {
+            return false;
+        }
+        loaded.nodeTracks[loaded.trackNodes[track]] = (int)track;
+    }
+    loaded.transforms.resize((size_t)header.numFrames * header.numTracks * SampledTracks::MATRIX_FLOATS);
+    file.read(reinterpret_cast<char*>(loaded.transforms.data()), (std::streamsize)(loaded.transforms.size() * sizeof(float)));
+    if (!file) {
+        return false;
+    }
+
+    tracks = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <assimp/matrix4x4.h>
+
+#include "AnimationBinding.h"
+#include "Skeleton.h"
+#include "ThreadPool.h"
+
+// Canali dell'animazione ricampionati una sola volta sugli istanti del bake: per ogni frame e ogni
+// nodo animato (traccia) la trasformazione locale come matrice 3x4 per righe, la cui quarta riga e'
+// sempre (0, 0, 0, 1). Durante il bake la posa di un frame si ottiene leggendo l'array e moltiplicando
+// lungo la gerarchia, senza ricerca delle chiavi ne' interpolazione.
+struct SampledTracks {
+    static const unsigned int MATRIX_FLOATS = 12;
+
+    unsigned int numFrames = 0;
+    std::vector<int> nodeTracks;          // per nodo dello scheletro: indice della traccia, -1 se il nodo non e' animato
+    std::vector<unsigned int> trackNodes; // per traccia: indice del nodo
+    std::vector<float> transforms;        // [frame][traccia][MATRIX_FLOATS]
+    uint64_t fingerprint = 0;             // impronta di scheletro, canali e istanti, vedi computeTracksFingerprint
+
+    bool empty() const { return numFrames == 0; }
+    aiMatrix4x4 localTransformation(unsigned int frame, unsigned int track) const;
+};
+
+// Impronta (FNV-1a a 64 bit) dei nomi dei nodi, delle chiavi dei canali e degli istanti dei frame:
+// una cache salvata e' valida solo se l'impronta coincide
+uint64_t computeTracksFingerprint(const Skeleton& skeleton, const AnimationBinding& binding, const std::vector<float>& frameTimes);
+
+// Ricampiona tutti i canali legati allo scheletro; con threadPool le tracce vengono divise tra i thread
+SampledTracks sampleTracks(const Skeleton& skeleton, const AnimationBinding& binding, const std::vector<float>& frameTimes, ThreadPool* threadPool);
+
+// Salvataggio delle tracce in un file binario little endian: intestazione, trackNodes, transforms
+bool saveSampledTracks(const std::string& path, const SampledTracks& tracks);
+
+// Restituisce false se il file non esiste, non e' valido o e' stato calcolato con un'impronta diversa
+bool loadSampledTracks(const std::string& path, uint64_t fingerprint, const Skeleton& skeleton, SampledTracks& tracks);
@@ -0,0 +1,166 @@
+#include "SceneCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <assimp/Exporter.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/version.h>
+
+#include "MappedFile.h"
+#include "Profiler.h"
+
+static const char SCENE_CACHE_MAGIC[8] = { 'B', 'A', 'K', 'E', 'S', 'C', 'N', '\0' };
+static const uint32_t SCENE_CACHE_VERSION = 2;
+
+struct SceneCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t inputSize;
+    int64_t inputModified;
+    uint64_t hash;
+    uint64_t sceneSize; // byte del dump assbin che segue l'intestazione
+};
+static_assert(sizeof(SceneCacheHeader) == 48, "SceneCacheHeader deve occupare 48 byte");
+
+// XXH64: quattro accumulatori indipendenti su blocchi di 32 byte, veloce anche su file di diversi GB,
+// e un mescolamento finale per cui ogni bit dell'ingresso influenza tutti i bit dell'hash
+static const uint64_t XXH_PRIME1 = 11400714785074694791ull;
+static const uint64_t XXH_PRIME2 = 14029467366897019727ull;
+static const uint64_t XXH_PRIME3 = 1609587929392839161ull;
+static const uint64_t XXH_PRIME4 = 9650029242287828579ull;
+static const uint64_t XXH_PRIME5 = 2870177450012600261ull;
+
+static uint64_t rotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t read64(const unsigned char* data) {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint64_t xxhRound(uint64_t accumulator, uint64_t input) {
+    accumulator += input * XXH_PRIME2;
+    return rotateLeft(accumulator, 31) * XXH_PRIME1;
+}
+
+static uint64_t xxhMergeRound(uint64_t hash, uint64_t accumulator) {
+    hash ^= xxhRound(0, accumulator);
+    return hash * XXH_PRIME1 + XXH_PRIME4;
+}
+
+static uint64_t hashXxh64(const unsigned char* data, size_t size, uint64_t seed) {
+    const unsigned char* end = data + size;
+    uint64_t hash;
+    if (size >= 32) {
+        uint64_t v1 = seed + XXH_PRIME1 + XXH_PRIME2;
+        uint64_t v2 = seed + XXH_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME1;
+        for (; data + 32 <= end; data += 32) {
+            v1 = xxhRound(v1, read64(data));
+            v2 = xxhRound(v2, read64(data + 8));
+            v3 = xxhRound(v3, read64(data + 16));
+            v4 = xxhRound(v4, read64(data + 24));
+        }
+        hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        hash = xxhMergeRound(hash, v1);
+        hash = xxhMergeRound(hash, v2);
+        hash = xxhMergeRound(hash, v3);
+        hash = xxhMergeRound(hash, v4);
+    }
+    else {
+        hash = seed + XXH_PRIME5;
+    }
+    hash += (uint64_t)size;
+
+    for (; data + 8 <= end; data += 8) {
+        hash ^= xxhRound(0, read64(data));
+        hash = rotateLeft(hash, 27) * XXH_PRIME1 + XXH_PRIME4;
+    }
+    if (data + 4 <= end) {
+        uint32_t word;
+        std::memcpy(&word, data, sizeof(word));
+        hash ^= (uint64_t)word * XXH_PRIME1;
+        hash = rotateLeft(hash, 23) * XXH_PRIME2 + XXH_PRIME3;
+        data += 4;
+    }
+    for (; data < end; data++) {
+        hash ^= *data * XXH_PRIME5;
+        hash = rotateLeft(hash, 11) * XXH_PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+bool computeSceneCacheKey(const std::string& inputPath, unsigned int importFlags, SceneCacheKey& key) {
+    PROFILE_SCOPE("scene cache key");
+    std::error_code error;
+    std::filesystem::file_time_type modified = std::filesystem::last_write_time(inputPath, error);
+    MappedFile input;
+    if (error || !input.open(inputPath, MappedFileAccess::Sequential)) {
+        return false;
+    }
+    key.inputSize = input.size();
+    key.inputModified = (int64_t)modified.time_since_epoch().count();
+
+    // Anche la versione di Assimp fa parte della chiave, perche' il formato assbin dipende dalla versione
+    const uint64_t parameters[] = { input.size(), importFlags, aiGetVersionMajor(), aiGetVersionMinor(), aiGetVersionPatch(), aiGetVersionRevision() };
+    uint64_t seed = hashXxh64(reinterpret_cast<const unsigned char*>(parameters), sizeof(parameters), 0);
+    key.hash = hashXxh64(input.data(), input.size(), seed);
+    return true;
+}
+
+const aiScene* loadSceneCache(Assimp::Importer& importer, const std::string& path, const SceneCacheKey& key) {
+    PROFILE_SCOPE("load scene cache");
+    MappedFile file;
+    if (!file.open(path, MappedFileAccess::Sequential) || file.size() < sizeof(SceneCacheHeader)) {
+        return nullptr;
+    }
+
+    SceneCacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, SCENE_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != SCENE_CACHE_VERSION
+        || header.inputSize != key.inputSize || header.inputModified != key.inputModified || header.hash != key.hash
+        || header.sceneSize != file.size() - sizeof(header)) {
+        return nullptr;
+    }
+
+    // Il dump viene letto direttamente dalle pagine mappate. mArmature e mNode delle ossa sono puntatori
+    // e non vengono salvati: li ricostruisce di nuovo PopulateArmatureData
+    return importer.ReadFileFromMemory(file.data() + sizeof(header), (size_t)header.sceneSize, aiProcess_PopulateArmatureData, "assbin");
+}
+
+bool saveSceneCache(const std::string& path, const SceneCacheKey& key, const aiScene* scene) {
+    PROFILE_SCOPE("save scene cache");
+    Assimp::Exporter exporter;
+    const aiExportDataBlob* blob = exporter.ExportToBlob(scene, "assbin");
+    // Il formato assbin produce un solo blob
+    if (!blob || blob->next) {
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    SceneCacheHeader header = {};
+    std::memcpy(header.magic, SCENE_CACHE_MAGIC, sizeof(header.magic));
+    header.version = SCENE_CACHE_VERSION;
+    header.inputSize = key.inputSize;
+    header.inputModified = key.inputModified;
+    header.hash = key.hash;
+    header.sceneSize = blob->size;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(static_cast<const char*>(blob->data), (std::streamsize)blob->size);
+    file.close();
+    return !file.fail();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+
+// Cache della scena gia' importata e post-processata, per evitare di rileggere il file di ingresso
+// quando si ripete il bake dello stesso modello con impostazioni diverse. Il file contiene
+// un'intestazione con la chiave seguita dal dump binario della scena nel formato assbin di Assimp.
+
+// Chiave della cache. Dimensione e data di modifica del file di ingresso permettono di scartare
+// subito una cache vecchia; l'hash (XXH64) copre il contenuto del file, le opzioni di importazione
+// e la versione di Assimp. I file esterni referenziati dal modello non fanno parte della chiave.
+struct SceneCacheKey {
+    uint64_t inputSize = 0;
+    int64_t inputModified = 0; // nell'unita' di std::filesystem::file_time_type
+    uint64_t hash = 0;
+};
+
+// Restituisce false se il file di ingresso non puo' essere letto
+bool computeSceneCacheKey(const std::string& inputPath, unsigned int importFlags, SceneCacheKey& key);
+
+// Mappa in memoria il file della cache e ne importa la scena; restituisce nullptr se il file non
+// esiste, non e' valido o e' stato salvato con una chiave diversa. La scena appartiene all'importer
+const aiScene* loadSceneCache(Assimp::Importer& importer, const std::string& path, const SceneCacheKey& key);
+
+bool saveSceneCache(const std::string& path, const SceneCacheKey& key, const aiScene* scene);
@@ -0,0 +1,31 @@
+#include "Skeleton.h"
+
+static void collectNodes(const aiNode* node, int parentIndex, Skeleton& skeleton) {
+    const unsigned int nodeIndex = skeleton.size();
+    skeleton.nodes.push_back(node);
+    skeleton.parentIndices.push_back(parentIndex);
+    skeleton.subtreeEnds.push_back(nodeIndex + 1);
+    skeleton.localTransformations.push_back(node->mTransformation);
+    skeleton.nodeIndices.emplace(node->mName.C_Str(), nodeIndex);
+
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+        if (node->mChildren[i]) {
+            collectNodes(node->mChildren[i], (int)nodeIndex, skeleton);
+        }
+    }
+    skeleton.subtreeEnds[nodeIndex] = skeleton.size();
+}
+
+int Skeleton::findNode(const aiString& name) const {
+    auto it = nodeIndices.find(name.C_Str());
+    return it != nodeIndices.end() ? (int)it->second : -1;
+}
+
+Skeleton buildSkeleton(const aiScene* scene) {
+    Skeleton skeleton;
+    collectNodes(scene->mRootNode, Skeleton::NO_PARENT, skeleton);
+
+    skeleton.globalInverseTransformation = scene->mRootNode->mTransformation;
+    skeleton.globalInverseTransformation.Inverse();
+    return skeleton;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <assimp/scene.h>
+#include <assimp/matrix4x4.h>
+
+// Gerarchia dei nodi della scena compilata in array contigui, costruita una sola volta dopo l'import.
+// I nodi sono in ordine di visita in profondita': ogni padre precede i propri figli, per cui le
+// trasformazioni globali si ottengono con un unico ciclo in avanti global[i] = global[parent[i]] * local[i].
+// Il sottoalbero del nodo i occupa l'intervallo contiguo [i, subtreeEnds[i]).
+struct Skeleton {
+    static constexpr int NO_PARENT = -1;
+
+    std::vector<const aiNode*> nodes;
+    std::vector<int> parentIndices;
+    std::vector<unsigned int> subtreeEnds;
+    std::vector<aiMatrix4x4> localTransformations; // trasformazioni locali in bind pose
+    std::unordered_map<std::string, unsigned int> nodeIndices;
+    aiMatrix4x4 globalInverseTransformation; // inversa della trasformazione della radice
+
+    unsigned int size() const { return (unsigned int)nodes.size(); }
+
+    // Restituisce l'indice del nodo con il nome dato, oppure -1 se non esiste
+    int findNode(const aiString& name) const;
+};
+
+Skeleton buildSkeleton(const aiScene* scene);
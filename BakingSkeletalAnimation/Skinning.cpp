@@ -0,0 +1,210 @@
+#include "Skinning.h"
+
+#include <algorithm>
+
+#include "Profiler.h"
+#include "SkinningSimd.h"
+
+// Vertici per blocco nello skinning parallelo: la divisione non dipende dal numero di thread
+static const unsigned int PARALLEL_SKINNING_BLOCK = 16384;
+
+// Kernel scelto con setSkinningKernel, da impostare prima di avviare i thread del bake
+static SkinningKernel currentKernel = SkinningKernel::Automatic;
+
+static SkinningKernel bestSupportedKernel() {
+    static const SkinningKernel best = skinningKernelSupported(SkinningKernel::Avx2) ? SkinningKernel::Avx2
+        : skinningKernelSupported(SkinningKernel::Sse41) ? SkinningKernel::Sse41
+        : SkinningKernel::Scalar;
+    return best;
+}
+
+SkinningData buildSkinningData(const aiMesh* mesh, const Skeleton& skeleton) {
+    SkinningData skinning;
+    skinning.influenceOffsets.assign(mesh->mNumVertices + 1, 0);
+
+    // Risolve una sola volta il nodo dello scheletro associato a ogni osso
+    skinning.boneNodeIndices.resize(mesh->mNumBones);
+    skinning.offsetMatrices.resize(mesh->mNumBones);
+    for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+        skinning.boneNodeIndices[b] = skeleton.findNode(mesh->mBones[b]->mName);
+        skinning.offsetMatrices[b] = mesh->mBones[b]->mOffsetMatrix;
+    }
+
+#ifndef ASSIMP_BUILD_NO_ARMATUREPOPULATE_PROCESS
+    // Con aiProcess_PopulateArmatureData basta valutare il sottoalbero dell'armatura
+    if (mesh->mNumBones > 0 && mesh->mBones[0]->mArmature) {
+        int armatureIndex = skeleton.findNode(mesh->mBones[0]->mArmature->mName);
+        skinning.armatureIndex = armatureIndex >= 0 ? (unsigned int)armatureIndex : 0;
+    }
+
+    // mArmature e' il primo antenato che non e' un osso: con giunti senza pesi o nodi $AssimpFbx$ le ossa
+    // della stessa mesh possono avere armature diverse. Si risale finche' il sottoalbero non contiene
+    // tutte le ossa, cioe' fino all'antenato comune (al piu' la radice)
+    auto containsAllBones = [&](unsigned int rootIndex) {
+        for (int nodeIndex : skinning.boneNodeIndices) {
+            if (nodeIndex >= 0 && ((unsigned int)nodeIndex < rootIndex || (unsigned int)nodeIndex >= skeleton.subtreeEnds[rootIndex])) {
+                return false;
+            }
+        }
+        return true;
+    };
+    while (skinning.armatureIndex != 0 && !containsAllBones(skinning.armatureIndex)) {
+        int parentIndex = skeleton.parentIndices[skinning.armatureIndex];
+        skinning.armatureIndex = parentIndex != Skeleton::NO_PARENT ? (unsigned int)parentIndex : 0;
+    }
+#endif
+
+    // Primo passaggio: conta le influenze di ogni vertice
+    for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+        const aiBone* bone = mesh->mBones[b];
+        for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+            if (bone->mWeights[w].mVertexId < mesh->mNumVertices && bone->mWeights[w].mWeight > 0.0f) {
+                skinning.influenceOffsets[bone->mWeights[w].mVertexId + 1]++;
+            }
+        }
+    }
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+        skinning.influenceOffsets[i + 1] += skinning.influenceOffsets[i];
+    }
+
+    // Secondo passaggio: riempie la tabella
+    skinning.influences.resize(skinning.influenceOffsets[mesh->mNumVertices]);
+    std::vector<unsigned int> cursor(skinning.influenceOffsets.begin(), skinning.influenceOffsets.end() - 1);
+    for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+        const aiBone* bone = mesh->mBones[b];
+        for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+            const aiVertexWeight& vertexWeight = bone->mWeights[w];
+            if (vertexWeight.mVertexId < mesh->mNumVertices && vertexWeight.mWeight > 0.0f) {
+                skinning.influences[cursor[vertexWeight.mVertexId]++] = { b, vertexWeight.mWeight };
+            }
+        }
+    }
+
+    // Tabella a larghezza fissa per i kernel SIMD
+    const unsigned int numVertices = mesh->mNumVertices;
+    for (unsigned int i = 0; i < numVertices; i++) {
+        skinning.maxInfluences = std::max(skinning.maxInfluences, skinning.influenceOffsets[i + 1] - skinning.influenceOffsets[i]);
+    }
+    skinning.maxInfluences = std::max(skinning.maxInfluences, 1u);
+    skinning.paddedBoneIndices.assign((size_t)skinning.maxInfluences * numVertices, 0);
+    skinning.paddedWeights.assign((size_t)skinning.maxInfluences * numVertices, 0.0f);
+    for (unsigned int i = 0; i < numVertices; i++) {
+        const unsigned int begin = skinning.influenceOffsets[i];
+        const unsigned int end = skinning.influenceOffsets[i + 1];
+        if (begin == end) {
+            skinning.paddedBoneIndices[i] = mesh->mNumBones;
+            skinning.paddedWeights[i] = 1.0f;
+        }
+        for (unsigned int k = begin; k < end; k++) {
+            skinning.paddedBoneIndices[(size_t)(k - begin) * numVertices + i] = skinning.influences[k].boneIndex;
+            skinning.paddedWeights[(size_t)(k - begin) * numVertices + i] = skinning.influences[k].weight;
+        }
+    }
+
+    return skinning;
+}
+
+void buildBonePalette(const SkinningData& skinning, const std::vector<aiMatrix4x4>& globalTransformations,
+    const aiMatrix4x4& globalInverseTransformation, std::vector<aiMatrix4x4>& palette) {
+    // L'ultima voce e' l'osso identita' dei vertici senza ossa
+    palette.resize(skinning.boneNodeIndices.size() + 1);
+    for (size_t b = 0; b < skinning.boneNodeIndices.size(); b++) {
+        int nodeIndex = skinning.boneNodeIndices[b];
+        palette[b] = nodeIndex >= 0 ? globalInverseTransformation * globalTransformations[nodeIndex] * skinning.offsetMatrices[b] : aiMatrix4x4();
+    }
+    palette.back() = aiMatrix4x4();
+}
+
+static void skinVertexRange(const BakeMesh& mesh, const SkinningData& skinning, const aiMatrix4x4* palette,
+    unsigned int firstVertex, unsigned int endVertex, SkinnedMesh& skinnedMesh) {
+    switch (activeSkinningKernel()) {
+    case SkinningKernel::Avx2:
+        firstVertex = skinVertexRangeAvx2(mesh, skinning, palette, firstVertex, endVertex, skinnedMesh);
+        break;
+    case SkinningKernel::Sse41:
+        firstVertex = skinVertexRangeSse41(mesh, skinning, palette, firstVertex, endVertex, skinnedMesh);
+        break;
+    default:
+        break;
+    }
+    skinVertexRangeScalar(mesh, skinning, palette, firstVertex, endVertex, skinnedMesh);
+}
+
+static void prepareOutput(const BakeMesh& mesh, SkinnedMesh& skinnedMesh) {
+    skinnedMesh.positions.resize(mesh.positions.size());
+    skinnedMesh.normals.resize(mesh.normals.size());
+}
+
+void skinVertices(const BakeMesh& mesh, const SkinningData& skinning, SkinnedMesh& skinnedMesh) {
+    prepareOutput(mesh, skinnedMesh);
+    skinVertexRange(mesh, skinning, skinnedMesh.palette.data(), 0, mesh.numVertices(), skinnedMesh);
+}
+
+void skinVerticesParallel(ThreadPool& threadPool, const BakeMesh& mesh, const SkinningData& skinning, SkinnedMesh& skinnedMesh) {
+    prepareOutput(mesh, skinnedMesh);
+    const unsigned int numVertices = mesh.numVertices();
+    const unsigned int numBlocks = (numVertices + PARALLEL_SKINNING_BLOCK - 1) / PARALLEL_SKINNING_BLOCK;
+    threadPool.parallelFor(numBlocks, 1, [&](unsigned int, unsigned int block) {
+        unsigned int firstVertex = block * PARALLEL_SKINNING_BLOCK;
+        unsigned int endVertex = std::min(firstVertex + PARALLEL_SKINNING_BLOCK, numVertices);
+        skinVertexRange(mesh, skinning, skinnedMesh.palette.data(), firstVertex, endVertex, skinnedMesh);
+    });
+}
+
+void applyPoseToMesh(const BakeMesh& mesh, const SkinningData& skinning, const Skeleton& skeleton, const std::vector<aiMatrix4x4>& globalTransformations,
+    SkinnedMesh& skinnedMesh, ThreadPool* vertexThreadPool) {
+    PROFILE_SCOPE("skinning");
+    if (!skinning.hasBones()) {
+        // La mesh non ha ossa, quindi non c'e' bisogno di applicare una posa.
+        skinnedMesh.positions = mesh.positions;
+        skinnedMesh.normals = mesh.normals;
+        return;
+    }
+
+    // Palette delle ossa: trasformazione globale dell'osso nella posa corrente per la sua matrice di offset
+    buildBonePalette(skinning, globalTransformations, skeleton.globalInverseTransformation, skinnedMesh.palette);
+
+    // Linear blend skinning per vertice: legge la bind pose della mesh e scrive nei buffer di uscita
+    if (vertexThreadPool) {
+        skinVerticesParallel(*vertexThreadPool, mesh, skinning, skinnedMesh);
+    }
+    else {
+        skinVertices(mesh, skinning, skinnedMesh);
+    }
+}
+
+bool useParallelSkinning(SkinningMode mode, unsigned int numVertices, unsigned int parallelThreshold) {
+    switch (mode) {
+    case SkinningMode::Parallel:
+        return true;
+    case SkinningMode::Automatic:
+        return numVertices >= parallelThreshold;
+    default:
+        return false;
+    }
+}
+
+bool setSkinningKernel(SkinningKernel kernel) {
+    if (kernel != SkinningKernel::Automatic && !skinningKernelSupported(kernel)) {
+        return false;
+    }
+    currentKernel = kernel;
+    return true;
+}
+
+SkinningKernel activeSkinningKernel() {
+    return currentKernel == SkinningKernel::Automatic ? bestSupportedKernel() : currentKernel;
+}
+
+const char* skinningKernelName(SkinningKernel kernel) {
+    switch (kernel) {
+    case SkinningKernel::Scalar:
+        return "scalar";
+    case SkinningKernel::Sse41:
+        return "sse41";
+    case SkinningKernel::Avx2:
+        return "avx2";
+    default:
+        return "auto";
+    }
+}
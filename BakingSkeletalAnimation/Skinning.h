@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <assimp/scene.h>
+#include <assimp/matrix4x4.h>
+
+#include "BakeMesh.h"
+#include "Skeleton.h"
+#include "ThreadPool.h"
+
+// Divisione dei vertici di una mesh tra i thread durante lo skinning
+enum class SkinningMode {
+    Serial,
+    Parallel,
+    Automatic // in parallelo solo sopra la soglia di vertici
+};
+
+// Implementazione del ciclo di skinning. Automatic sceglie la migliore supportata dalla CPU.
+// I kernel SIMD elaborano 4 (SSE4.1) o 8 (AVX2) vertici per istruzione e seguono lo stesso ordine
+// delle operazioni del kernel scalare, senza FMA: le posizioni coincidono con il percorso scalare
+// entro 1e-5 relativo (di norma sono identiche). Unica eccezione i vertici senza ossa, la cui normale
+// viene rinormalizzata invece di essere copiata.
+enum class SkinningKernel {
+    Automatic,
+    Scalar,
+    Sse41,
+    Avx2
+};
+
+// Influenza di un osso su un vertice
+struct VertexInfluence {
+    unsigned int boneIndex;
+    float weight;
+};
+
+// Tabella appiattita delle influenze della mesh, costruita una sola volta da aiBone::mWeights.
+// Le influenze del vertice i si trovano in influences[influenceOffsets[i], influenceOffsets[i + 1]).
+// Per i kernel SIMD la stessa tabella e' anche riempita a larghezza fissa: l'influenza k del vertice i
+// e' in paddedBoneIndices/paddedWeights[k * numVertices + i], con peso nullo oltre le influenze reali.
+// I vertici senza ossa usano l'osso identita' in coda alla palette con peso 1.
+struct SkinningData {
+    std::vector<unsigned int> influenceOffsets;
+    std::vector<VertexInfluence> influences;
+    unsigned int maxInfluences = 0;
+    AlignedVector<unsigned int> paddedBoneIndices;
+    AlignedVector<float> paddedWeights;
+    std::vector<int> boneNodeIndices; // nodo dello scheletro di ogni aiBone, -1 se non trovato
+    std::vector<aiMatrix4x4> offsetMatrices;
+    unsigned int armatureIndex = 0; // radice di un sottoalbero che contiene tutte le ossa, 0 se sconosciuta
+
+    bool hasBones() const { return !boneNodeIndices.empty(); }
+};
+
+// Vertici e normali di una mesh nella posa del frame. La bind pose della BakeMesh resta intatta:
+// il chiamante possiede questi buffer e li riusa tra i frame senza nuove allocazioni.
+struct SkinnedMesh {
+    VertexStream positions;
+    VertexStream normals; // vuoto se la mesh non ha normali
+    std::vector<aiMatrix4x4> palette; // palette delle ossa del frame corrente
+};
+
+SkinningData buildSkinningData(const aiMesh* mesh, const Skeleton& skeleton);
+
+// Costruisce la palette della mesh indicizzando per osso le trasformazioni globali dei nodi
+void buildBonePalette(const SkinningData& skinning, const std::vector<aiMatrix4x4>& globalTransformations,
+    const aiMatrix4x4& globalInverseTransformation, std::vector<aiMatrix4x4>& palette);
+
+// Linear blend skinning della bind pose di mesh nei flussi di skinnedMesh, con la palette di skinnedMesh:
+// palette[b] = globalBoneTransform * mOffsetMatrix dell'osso b
+void skinVertices(const BakeMesh& mesh, const SkinningData& skinning, SkinnedMesh& skinnedMesh);
+
+// Come skinVertices, ma divide i vertici in blocchi di dimensione fissa eseguiti dal pool di thread.
+// Ogni vertice e' calcolato dalle stesse istruzioni del percorso seriale, quindi il risultato e' identico bit a bit.
+void skinVerticesParallel(ThreadPool& threadPool, const BakeMesh& mesh, const SkinningData& skinning, SkinnedMesh& skinnedMesh);
+
+// Applica la posa descritta da globalTransformations alla mesh: palette delle ossa e skinning dei vertici,
+// divisi tra i thread di vertexThreadPool se non e' nullo. Una mesh senza ossa viene copiata.
+void applyPoseToMesh(const BakeMesh& mesh, const SkinningData& skinning, const Skeleton& skeleton, const std::vector<aiMatrix4x4>& globalTransformations,
+    SkinnedMesh& skinnedMesh, ThreadPool* vertexThreadPool);
+
+bool useParallelSkinning(SkinningMode mode, unsigned int numVertices, unsigned int parallelThreshold);
+
+// Seleziona il kernel usato da tutte le chiamate successive; restituisce false se la CPU non lo supporta
+bool setSkinningKernel(SkinningKernel kernel);
+SkinningKernel activeSkinningKernel();
+const char* skinningKernelName(SkinningKernel kernel);
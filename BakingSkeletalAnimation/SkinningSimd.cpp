@@ -0,0 +1,260 @@
+#include "SkinningSimd.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SKINNING_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compila gli intrinsic SSE4.1/AVX2 senza opzioni, GCC e Clang li abilitano per singola funzione
+#if defined(SKINNING_X86) && !defined(_MSC_VER)
+#define SKINNING_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SKINNING_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SKINNING_TARGET_SSE41
+#define SKINNING_TARGET_AVX2
+#endif
+
+void skinVertexRangeScalar(const BakeMesh& mesh, const SkinningData& skinning, const aiMatrix4x4* palette,
+    unsigned int firstVertex, unsigned int endVertex, SkinnedMesh& skinnedMesh) {
+    const unsigned int* offsets = skinning.influenceOffsets.data();
+    const VertexInfluence* influences = skinning.influences.data();
+    const VertexStream& bindPositions = mesh.positions;
+    const VertexStream& bindNormals = mesh.normals;
+    VertexStream& positions = skinnedMesh.positions;
+    VertexStream& normals = skinnedMesh.normals;
+    const bool hasNormals = !bindNormals.empty();
+
+    for (unsigned int i = firstVertex; i < endVertex; i++) {
+        const unsigned int begin = offsets[i];
+        const unsigned int end = offsets[i + 1];
+
+        if (begin == end) {
+            // Vertice senza ossa: resta in bind pose
+            positions.x[i] = bindPositions.x[i];
+            positions.y[i] = bindPositions.y[i];
+            positions.z[i] = bindPositions.z[i];
+            if (hasNormals) {
+                normals.x[i] = bindNormals.x[i];
+                normals.y[i] = bindNormals.y[i];
+                normals.z[i] = bindNormals.z[i];
+            }
+            continue;
+        }
+
+        // Miscela le righe 3x4 delle matrici delle ossa pesate
+        float m[12] = {};
+        for (unsigned int k = begin; k < end; k++) {
+            const aiMatrix4x4& bone = palette[influences[k].boneIndex];
+            const float w = influences[k].weight;
+            m[0] += w * bone.a1; m[1] += w * bone.a2; m[2] += w * bone.a3; m[3] += w * bone.a4;
+            m[4] += w * bone.b1; m[5] += w * bone.b2; m[6] += w * bone.b3; m[7] += w * bone.b4;
+            m[8] += w * bone.c1; m[9] += w * bone.c2; m[10] += w * bone.c3; m[11] += w * bone.c4;
+        }
+
+        const float x = bindPositions.x[i];
+        const float y = bindPositions.y[i];
+        const float z = bindPositions.z[i];
+        positions.x[i] = m[0] * x + m[1] * y + m[2] * z + m[3];
+        positions.y[i] = m[4] * x + m[5] * y + m[6] * z + m[7];
+        positions.z[i] = m[8] * x + m[9] * y + m[10] * z + m[11];
+
+        if (hasNormals) {
+            // Le normali usano solo la parte 3x3 e vanno rinormalizzate dopo la miscela
+            const float nx = bindNormals.x[i];
+            const float ny = bindNormals.y[i];
+            const float nz = bindNormals.z[i];
+            aiVector3D transformedNormal(
+                m[0] * nx + m[1] * ny + m[2] * nz,
+                m[4] * nx + m[5] * ny + m[6] * nz,
+                m[8] * nx + m[9] * ny + m[10] * nz);
+            transformedNormal.Normalize();
+            normals.x[i] = transformedNormal.x;
+            normals.y[i] = transformedNormal.y;
+            normals.z[i] = transformedNormal.z;
+        }
+    }
+}
+
+#ifdef SKINNING_X86
+
+SKINNING_TARGET_SSE41
+unsigned int skinVertexRangeSse41(const BakeMesh& mesh, const SkinningData& skinning, const aiMatrix4x4* palette,
+    unsigned int firstVertex, unsigned int endVertex, SkinnedMesh& skinnedMesh) {
+    const size_t numVertices = mesh.positions.size();
+    const float* bones = reinterpret_cast<const float*>(palette);
+    const VertexStream& bindPositions = mesh.positions;
+    const VertexStream& bindNormals = mesh.normals;
+    VertexStream& positions = skinnedMesh.positions;
+    VertexStream& normals = skinnedMesh.normals;
+    const bool hasNormals = !bindNormals.empty();
+
+    unsigned int i = firstVertex;
+    for (; i + 4 <= endVertex; i += 4) {
+        __m128 m[12];
+        for (int c = 0; c < 12; c++) {
+            m[c] = _mm_setzero_ps();
+        }
+
+        for (unsigned int k = 0; k < skinning.maxInfluences; k++) {
+            const unsigned int* boneIndices = &skinning.paddedBoneIndices[k * numVertices + i];
+            const __m128 w = _mm_loadu_ps(&skinning.paddedWeights[k * numVertices + i]);
+
+            // Senza gather: carica le tre righe delle 4 matrici e le trasponde in vettori per componente
+            const float* bone0 = bones + boneIndices[0] * 16;
+            const float* bone1 = bones + boneIndices[1] * 16;
+            const float* bone2 = bones + boneIndices[2] * 16;
+            const float* bone3 = bones + boneIndices[3] * 16;
+            for (int row = 0; row < 3; row++) {
+                __m128 c0 = _mm_loadu_ps(bone0 + row * 4);
+                __m128 c1 = _mm_loadu_ps(bone1 + row * 4);
+                __m128 c2 = _mm_loadu_ps(bone2 + row * 4);
+                __m128 c3 = _mm_loadu_ps(bone3 + row * 4);
+                _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+                m[row * 4 + 0] = _mm_add_ps(m[row * 4 + 0], _mm_mul_ps(w, c0));
+                m[row * 4 + 1] = _mm_add_ps(m[row * 4 + 1], _mm_mul_ps(w, c1));
+                m[row * 4 + 2] = _mm_add_ps(m[row * 4 + 2], _mm_mul_ps(w, c2));
+                m[row * 4 + 3] = _mm_add_ps(m[row * 4 + 3], _mm_mul_ps(w, c3));
+            }
+        }
+
+        const __m128 x = _mm_loadu_ps(&bindPositions.x[i]);
+        const __m128 y = _mm_loadu_ps(&bindPositions.y[i]);
+        const __m128 z = _mm_loadu_ps(&bindPositions.z[i]);
+        for (int row = 0; row < 3; row++) {
+            __m128 value = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[row * 4], x), _mm_mul_ps(m[row * 4 + 1], y)),
+                _mm_mul_ps(m[row * 4 + 2], z)), m[row * 4 + 3]);
+            float* out = row == 0 ? &positions.x[i] : row == 1 ? &positions.y[i] : &positions.z[i];
+            _mm_storeu_ps(out, value);
+        }
+
+        if (hasNormals) {
+            const __m128 nx = _mm_loadu_ps(&bindNormals.x[i]);
+            const __m128 ny = _mm_loadu_ps(&bindNormals.y[i]);
+            const __m128 nz = _mm_loadu_ps(&bindNormals.z[i]);
+            __m128 n[3];
+            for (int row = 0; row < 3; row++) {
+                n[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[row * 4], nx), _mm_mul_ps(m[row * 4 + 1], ny)), _mm_mul_ps(m[row * 4 + 2], nz));
+            }
+
+            // Come aiVector3D::Normalize: le normali di lunghezza nulla restano invariate
+            __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(n[0], n[0]), _mm_mul_ps(n[1], n[1])), _mm_mul_ps(n[2], n[2])));
+            __m128 nonZero = _mm_cmpneq_ps(length, _mm_setzero_ps());
+            __m128 inverseLength = _mm_div_ps(_mm_set1_ps(1.0f), length);
+            _mm_storeu_ps(&normals.x[i], _mm_blendv_ps(n[0], _mm_mul_ps(n[0], inverseLength), nonZero));
+            _mm_storeu_ps(&normals.y[i], _mm_blendv_ps(n[1], _mm_mul_ps(n[1], inverseLength), nonZero));
+            _mm_storeu_ps(&normals.z[i], _mm_blendv_ps(n[2], _mm_mul_ps(n[2], inverseLength), nonZero));
+        }
+    }
+    return i;
+}
+
+SKINNING_TARGET_AVX2
+unsigned int skinVertexRangeAvx2(const BakeMesh& mesh, const SkinningData& skinning, const aiMatrix4x4* palette,
+    unsigned int firstVertex, unsigned int endVertex, SkinnedMesh& skinnedMesh) {
+    const size_t numVertices = mesh.positions.size();
+    const float* bones = reinterpret_cast<const float*>(palette);
+    const VertexStream& bindPositions = mesh.positions;
+    const VertexStream& bindNormals = mesh.normals;
+    VertexStream& positions = skinnedMesh.positions;
+    VertexStream& normals = skinnedMesh.normals;
+    const bool hasNormals = !bindNormals.empty();
+
+    unsigned int i = firstVertex;
+    for (; i + 8 <= endVertex; i += 8) {
+        __m256 m[12];
+        for (int c = 0; c < 12; c++) {
+            m[c] = _mm256_setzero_ps();
+        }
+
+        for (unsigned int k = 0; k < skinning.maxInfluences; k++) {
+            const __m256i boneIndices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&skinning.paddedBoneIndices[k * numVertices + i]));
+            const __m256 w = _mm256_loadu_ps(&skinning.paddedWeights[k * numVertices + i]);
+
+            // Ogni matrice occupa 16 float: la componente c dell'osso b e' in bones[b * 16 + c]
+            const __m256i boneOffsets = _mm256_slli_epi32(boneIndices, 4);
+            for (int c = 0; c < 12; c++) {
+                m[c] = _mm256_add_ps(m[c], _mm256_mul_ps(w, _mm256_i32gather_ps(bones + c, boneOffsets, 4)));
+            }
+        }
+
+        const __m256 x = _mm256_loadu_ps(&bindPositions.x[i]);
+        const __m256 y = _mm256_loadu_ps(&bindPositions.y[i]);
+        const __m256 z = _mm256_loadu_ps(&bindPositions.z[i]);
+        for (int row = 0; row < 3; row++) {
+            __m256 value = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[row * 4], x), _mm256_mul_ps(m[row * 4 + 1], y)),
+                _mm256_mul_ps(m[row * 4 + 2], z)), m[row * 4 + 3]);
+            float* out = row == 0 ? &positions.x[i] : row == 1 ? &positions.y[i] : &positions.z[i];
+            _mm256_storeu_ps(out, value);
+        }
+
+        if (hasNormals) {
+            const __m256 nx = _mm256_loadu_ps(&bindNormals.x[i]);
+            const __m256 ny = _mm256_loadu_ps(&bindNormals.y[i]);
+            const __m256 nz = _mm256_loadu_ps(&bindNormals.z[i]);
+            __m256 n[3];
+            for (int row = 0; row < 3; row++) {
+                n[row] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[row * 4], nx), _mm256_mul_ps(m[row * 4 + 1], ny)), _mm256_mul_ps(m[row * 4 + 2], nz));
+            }
+
+            // Come aiVector3D::Normalize: le normali di lunghezza nulla restano invariate
+            __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(n[0], n[0]), _mm256_mul_ps(n[1], n[1])), _mm256_mul_ps(n[2], n[2])));
+            __m256 nonZero = _mm256_cmp_ps(length, _mm256_setzero_ps(), _CMP_NEQ_OQ);
+            __m256 inverseLength = _mm256_div_ps(_mm256_set1_ps(1.0f), length);
+            _mm256_storeu_ps(&normals.x[i], _mm256_blendv_ps(n[0], _mm256_mul_ps(n[0], inverseLength), nonZero));
+            _mm256_storeu_ps(&normals.y[i], _mm256_blendv_ps(n[1], _mm256_mul_ps(n[1], inverseLength), nonZero));
+            _mm256_storeu_ps(&normals.z[i], _mm256_blendv_ps(n[2], _mm256_mul_ps(n[2], inverseLength), nonZero));
+        }
+    }
+    return i;
+}
+
+bool skinningKernelSupported(SkinningKernel kernel) {
+    switch (kernel) {
+    case SkinningKernel::Scalar:
+        return true;
+#ifdef _MSC_VER
+    case SkinningKernel::Sse41: {
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 19)) != 0;
+    }
+    case SkinningKernel::Avx2: {
+        // AVX2 richiede anche che il sistema operativo salvi i registri YMM (OSXSAVE + XCR0)
+        int info[4];
+        __cpuid(info, 1);
+        bool osSupport = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return osSupport && (info[1] & (1 << 5)) != 0;
+    }
+#else
+    case SkinningKernel::Sse41:
+        return __builtin_cpu_supports("sse4.1");
+    case SkinningKernel::Avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+#else
+
+// Architetture non x86: resta solo il kernel scalare
+unsigned int skinVertexRangeSse41(const BakeMesh&, const SkinningData&, const aiMatrix4x4*, unsigned int firstVertex, unsigned int, SkinnedMesh&) {
+    return firstVertex;
+}
+
+unsigned int skinVertexRangeAvx2(const BakeMesh&, const SkinningData&, const aiMatrix4x4*, unsigned int firstVertex, unsigned int, SkinnedMesh&) {
+    return firstVertex;
+}
+
+bool skinningKernelSupported(SkinningKernel kernel) {
+    return kernel == SkinningKernel::Scalar;
+}
+
+#endif
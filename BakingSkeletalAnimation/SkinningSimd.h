@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Skinning.h"
+
+// Kernel di skinning per l'intervallo di vertici [firstVertex, endVertex), usati dal dispatch di Skinning.cpp.
+// I kernel SIMD elaborano i vertici a gruppi di 4 o 8 e restituiscono il primo vertice non elaborato,
+// che il chiamante completa con il kernel scalare.
+void skinVertexRangeScalar(const BakeMesh& mesh, const SkinningData& skinning, const aiMatrix4x4* palette,
+    unsigned int firstVertex, unsigned int endVertex, SkinnedMesh& skinnedMesh);
+unsigned int skinVertexRangeSse41(const BakeMesh& mesh, const SkinningData& skinning, const aiMatrix4x4* palette,
+    unsigned int firstVertex, unsigned int endVertex, SkinnedMesh& skinnedMesh);
+unsigned int skinVertexRangeAvx2(const BakeMesh& mesh, const SkinningData& skinning, const aiMatrix4x4* palette,
+    unsigned int firstVertex, unsigned int endVertex, SkinnedMesh& skinnedMesh);
+
+bool skinningKernelSupported(SkinningKernel kernel);
@@ -0,0 +1,268 @@
+#include "SyntheticScene.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const double SYNTHETIC_TICKS_PER_SECOND = 30.0;
+static const float BONE_LENGTH = 1.0f;
+static const float SIBLING_SPACING = 0.5f;
+static const float VERTEX_SPREAD = 0.3f;   // distanza massima dei vertici dall'osso principale, per asse
+static const float MAX_SWING = 0.5f;       // ampiezza della rotazione delle ossa, in radianti
+static const float PI = 3.14159265358979f;
+
+// Generatore xorshift32: stessa sequenza su ogni piattaforma, a differenza delle distribuzioni della libreria standard
+class SyntheticRandom {
+public:
+    explicit SyntheticRandom(unsigned int seed) : state(seed != 0 ? seed : 0x9E3779B9u) {}
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Valore in [minimum, maximum)
+    float uniform(float minimum, float maximum) {
+        return minimum + (next() >> 8) * (1.0f / 16777216.0f) * (maximum - minimum);
+    }
+
+private:
+    uint32_t state;
+};
+
+static bool parseValue(const char* text, size_t length, double& value) {
+    std::string number(text, length);
+    char* end = nullptr;
+    value = std::strtod(number.c_str(), &end);
+    return !number.empty() && *end == '\0' && value >= 0.0;
+}
+
+bool parseSyntheticSceneSettings(const char* text, SyntheticSceneSettings& settings) {
+    while (*text != '\0') {
+        const char* separator = std::strchr(text, ',');
+        size_t length = separator ? (size_t)(separator - text) : std::strlen(text);
+        const char* equals = (const char*)std::memchr(text, '=', length);
+        if (!equals) {
+            return false;
+        }
+        std::string key(text, equals - text);
+        double value = 0.0;
+        if (!parseValue(equals + 1, length - (equals + 1 - text), value)) {
+            return false;
+        }
+
+        if (key == "bones" && value >= 1.0) {
+            settings.numBones = (unsigned int)value;
+        }
+        else if (key == "depth" && value >= 1.0) {
+            settings.depth = (unsigned int)value;
+        }
+        else if (key == "branching" && value >= 1.0) {
+            settings.branching = (unsigned int)value;
+        }
+        else if (key == "vertices" && value >= 1.0) {
+            settings.numVertices = (unsigned int)value;
+        }
+        else if (key == "influences" && value >= 1.0) {
+            settings.influences = (unsigned int)value;
+        }
+        else if (key == "keys" && value >= 1.0) {
+            settings.numKeys = (unsigned int)value;
+        }
+        else if (key == "duration" && value > 0.0) {
+            settings.duration = (float)value;
+        }
+        else if (key == "seed" && value >= 0.0 && value <= UINT_MAX && value == std::floor(value)) {
+            settings.seed = (unsigned int)value;
+        }
+        else {
+            return false;
+        }
+        text += separator ? length + 1 : length;
+    }
+    return true;
+}
+
+static void setChildren(aiNode* node, const std::vector<aiNode*>& children) {
+    node->mNumChildren = (unsigned int)children.size();
+    node->mChildren = children.empty() ? nullptr : new aiNode*[children.size()];
+    for (size_t i = 0; i < children.size(); i++) {
+        node->mChildren[i] = children[i];
+        children[i]->mParent = node;
+    }
+}
+
+std::unique_ptr<aiScene> buildSyntheticScene(const SyntheticSceneSettings& settings) {
+    SyntheticRandom random(settings.seed);
+    const unsigned int numBones = std::max(1u, settings.numBones);
+    const unsigned int maxDepth = std::max(1u, settings.depth);
+    const unsigned int branching = std::max(1u, settings.branching);
+    const unsigned int numVertices = settings.numVertices;
+    const unsigned int numInfluences = std::min(std::max(1u, settings.influences), numBones);
+    const unsigned int numKeys = std::max(1u, settings.numKeys);
+
+    // Albero delle ossa in ampiezza: candidates contiene le ossa che possono ancora avere figli
+    std::vector<int> parents(numBones, -1);
+    std::vector<unsigned int> depths(numBones, 1);
+    std::vector<unsigned int> childCounts(numBones, 0);
+    std::vector<unsigned int> candidates;
+    size_t cursor = 0;
+    if (maxDepth > 1) {
+        candidates.push_back(0);
+    }
+    for (unsigned int bone = 1; bone < numBones; bone++) {
+        if (!candidates.empty()) {
+            unsigned int parent = candidates[cursor];
+            parents[bone] = (int)parent;
+            depths[bone] = depths[parent] + 1;
+            if (++childCounts[parent] % branching == 0) {
+                cursor = (cursor + 1) % candidates.size();
+            }
+            if (depths[bone] < maxDepth) {
+                candidates.push_back(bone);
+            }
+        }
+    }
+
+    // Nodi: radice della scena, armatura e ossa. I fratelli sono affiancati lungo x, i figli proseguono lungo y.
+    std::unique_ptr<aiScene> scene(new aiScene());
+    aiNode* root = new aiNode("Scene");
+    aiNode* armature = new aiNode("Armature");
+    scene->mRootNode = root;
+    setChildren(root, { armature });
+
+    std::vector<aiNode*> boneNodes(numBones);
+    std::vector<std::vector<aiNode*>> boneChildren(numBones);
+    std::vector<aiNode*> rootBones;
+    std::vector<aiMatrix4x4> bindGlobals(numBones);
+    std::vector<unsigned int> siblingIndices(numBones);
+    std::vector<unsigned int> siblingCounts(numBones + 1, 0); // l'ultima voce conta le ossa figlie dell'armatura
+    for (unsigned int bone = 0; bone < numBones; bone++) {
+        unsigned int parentSlot = parents[bone] < 0 ? numBones : (unsigned int)parents[bone];
+        siblingIndices[bone] = siblingCounts[parentSlot]++;
+    }
+    for (unsigned int bone = 0; bone < numBones; bone++) {
+        aiNode* node = new aiNode("Bone_" + std::to_string(bone));
+        unsigned int parentSlot = parents[bone] < 0 ? numBones : (unsigned int)parents[bone];
+        float offset = (siblingIndices[bone] - (siblingCounts[parentSlot] - 1) * 0.5f) * SIBLING_SPACING;
+        aiMatrix4x4::Translation(aiVector3D(offset, parents[bone] < 0 ? 0.0f : BONE_LENGTH, 0.0f), node->mTransformation);
+        bindGlobals[bone] = parents[bone] < 0 ? node->mTransformation : bindGlobals[parents[bone]] * node->mTransformation;
+        boneNodes[bone] = node;
+        if (parents[bone] < 0) {
+            rootBones.push_back(node);
+        }
+        else {
+            boneChildren[parents[bone]].push_back(node);
+        }
+    }
+    setChildren(armature, rootBones);
+    for (unsigned int bone = 0; bone < numBones; bone++) {
+        setChildren(boneNodes[bone], boneChildren[bone]);
+    }
+
+    // Mesh: i vertici sono divisi in blocchi consecutivi per osso principale, attorno alla sua posizione in bind pose
+    aiMesh* mesh = new aiMesh();
+    mesh->mName = aiString("SyntheticMesh");
+    mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+    mesh->mNumVertices = numVertices;
+    mesh->mVertices = new aiVector3D[numVertices];
+    mesh->mNormals = new aiVector3D[numVertices];
+    mesh->mTextureCoords[0] = new aiVector3D[numVertices];
+    mesh->mNumUVComponents[0] = 2;
+    std::vector<unsigned int> primaryBones(numVertices);
+    for (unsigned int v = 0; v < numVertices; v++) {
+        unsigned int bone = (unsigned int)((uint64_t)v * numBones / numVertices);
+        primaryBones[v] = bone;
+        aiVector3D jitter(random.uniform(-VERTEX_SPREAD, VERTEX_SPREAD), random.uniform(-VERTEX_SPREAD, VERTEX_SPREAD), random.uniform(-VERTEX_SPREAD, VERTEX_SPREAD));
+        const aiMatrix4x4& bind = bindGlobals[bone];
+        mesh->mVertices[v] = aiVector3D(bind.a4, bind.b4, bind.c4) + jitter;
+        mesh->mNormals[v] = jitter.SquareLength() > 0.0f ? jitter.Normalize() : aiVector3D(0.0f, 1.0f, 0.0f);
+        mesh->mTextureCoords[0][v] = aiVector3D((float)v / numVertices, random.uniform(0.0f, 1.0f), 0.0f);
+    }
+
+    // Strisce di triangoli sui vertici consecutivi
+    mesh->mNumFaces = numVertices >= 3 ? numVertices - 2 : 0;
+    mesh->mFaces = mesh->mNumFaces > 0 ? new aiFace[mesh->mNumFaces] : nullptr;
+    for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
+        mesh->mFaces[f].mNumIndices = 3;
+        mesh->mFaces[f].mIndices = new unsigned int[3] { f, f + 1, f + 2 };
+    }
+
+    // Influenze: l'osso principale, poi i suoi antenati e infine le ossa successive, con pesi decrescenti
+    const float weightSum = numInfluences * (numInfluences + 1) * 0.5f;
+    std::vector<std::vector<aiVertexWeight>> boneWeights(numBones);
+    std::vector<unsigned int> vertexBones(numInfluences);
+    for (unsigned int v = 0; v < numVertices; v++) {
+        unsigned int count = 0;
+        for (int bone = (int)primaryBones[v]; bone >= 0 && count < numInfluences; bone = parents[bone]) {
+            vertexBones[count++] = (unsigned int)bone;
+        }
+        for (unsigned int step = 1; count < numInfluences; step++) {
+            unsigned int bone = (primaryBones[v] + step) % numBones;
+            if (std::find(vertexBones.begin(), vertexBones.begin() + count, bone) == vertexBones.begin() + count) {
+                vertexBones[count++] = bone;
+            }
+        }
+        for (unsigned int k = 0; k < numInfluences; k++) {
+            boneWeights[vertexBones[k]].push_back(aiVertexWeight(v, (numInfluences - k) / weightSum));
+        }
+    }
+    mesh->mNumBones = numBones;
+    mesh->mBones = new aiBone*[numBones];
+    for (unsigned int bone = 0; bone < numBones; bone++) {
+        aiBone* meshBone = new aiBone();
+        meshBone->mName = boneNodes[bone]->mName;
+        meshBone->mArmature = armature;
+        meshBone->mNode = boneNodes[bone];
+        meshBone->mOffsetMatrix = aiMatrix4x4(bindGlobals[bone]).Inverse();
+        meshBone->mNumWeights = (unsigned int)boneWeights[bone].size();
+        meshBone->mWeights = boneWeights[bone].empty() ? nullptr : new aiVertexWeight[boneWeights[bone].size()];
+        std::copy(boneWeights[bone].begin(), boneWeights[bone].end(), meshBone->mWeights);
+        mesh->mBones[bone] = meshBone;
+    }
+
+    scene->mNumMeshes = 1;
+    scene->mMeshes = new aiMesh*[1] { mesh };
+    root->mNumMeshes = 1;
+    root->mMeshes = new unsigned int[1] { 0 };
+
+    // Animazione: ogni osso oscilla attorno a un asse casuale, con chiavi equidistanti su tutti i canali
+    aiAnimation* animation = new aiAnimation();
+    animation->mName = aiString("SyntheticAnimation");
+    animation->mDuration = settings.duration;
+    animation->mTicksPerSecond = SYNTHETIC_TICKS_PER_SECOND;
+    animation->mNumChannels = numBones;
+    animation->mChannels = new aiNodeAnim*[numBones];
+    for (unsigned int bone = 0; bone < numBones; bone++) {
+        aiNodeAnim* channel = new aiNodeAnim();
+        channel->mNodeName = boneNodes[bone]->mName;
+        channel->mNumPositionKeys = numKeys;
+        channel->mNumRotationKeys = numKeys;
+        channel->mNumScalingKeys = numKeys;
+        channel->mPositionKeys = new aiVectorKey[numKeys];
+        channel->mRotationKeys = new aiQuatKey[numKeys];
+        channel->mScalingKeys = new aiVectorKey[numKeys];
+
+        aiVector3D axis(random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f));
+        axis = axis.SquareLength() > 0.0f ? axis.Normalize() : aiVector3D(0.0f, 0.0f, 1.0f);
+        float phase = random.uniform(0.0f, 2.0f * PI);
+        const aiMatrix4x4& local = boneNodes[bone]->mTransformation;
+        for (unsigned int k = 0; k < numKeys; k++) {
+            double time = numKeys > 1 ? settings.duration * k / (numKeys - 1) : 0.0;
+            float angle = MAX_SWING * std::sin(2.0f * PI * (float)(time / settings.duration) + phase);
+            channel->mPositionKeys[k] = aiVectorKey(time, aiVector3D(local.a4, local.b4, local.c4));
+            channel->mRotationKeys[k] = aiQuatKey(time, aiQuaternion(axis, angle));
+            channel->mScalingKeys[k] = aiVectorKey(time, aiVector3D(1.0f, 1.0f, 1.0f));
+        }
+        animation->mChannels[bone] = channel;
+    }
+    scene->mNumAnimations = 1;
+    scene->mAnimations = new aiAnimation*[1] { animation };
+    return scene;
+}
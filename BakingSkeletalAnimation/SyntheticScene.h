@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include <assimp/scene.h>
+
+// Parametri della scena generata. Le ossa riempiono l'albero in ampiezza: ogni osso ha al piu'
+// branching figli e nessun osso supera la profondita' depth; le ossa che non trovano posto
+// nell'albero completo vengono distribuite a turno tra le ossa che possono avere figli.
+struct SyntheticSceneSettings {
+    unsigned int numBones = 64;
+    unsigned int depth = 8;            // livelli di ossa sotto l'armatura, almeno 1
+    unsigned int branching = 2;        // figli per osso, almeno 1
+    unsigned int numVertices = 10000;
+    unsigned int influences = 4;       // ossa per vertice, limitate al numero di ossa
+    unsigned int numKeys = 30;         // chiavi per canale (posizione, rotazione e scala)
+    float duration = 100.0f;           // durata dell'animazione in tick, a 30 tick al secondo
+    unsigned int seed = 1;
+};
+
+// Legge una specifica come "bones=1000,depth=10,vertices=1000000"; le chiavi non indicate mantengono
+// il valore attuale. Restituisce false per chiavi sconosciute o valori non validi.
+bool parseSyntheticSceneSettings(const char* text, SyntheticSceneSettings& settings);
+
+// Costruisce in memoria una scena con un'armatura, una mesh skinnata di soli triangoli con normali
+// e UV, e un'animazione con un canale per osso. Il risultato equivale a un file importato con le
+// opzioni del bake (aiBone::mArmature e mNode sono gia' valorizzati) ed e' deterministico per seed.
+std::unique_ptr<aiScene> buildSyntheticScene(const SyntheticSceneSettings& settings);
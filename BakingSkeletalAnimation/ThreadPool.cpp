@@ -0,0 +1,137 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int numThreads) {
+    if (numThreads == 0) {
+        numThreads = std::thread::hardware_concurrency();
+    }
+    if (numThreads == 0) {
+        numThreads = 1;
+    }
+
+    for (unsigned int i = 0; i < numThreads; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned int i = 1; i < numThreads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(unsigned int count, unsigned int grain, const Task& task) {
+    if (count == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = 1;
+    }
+
+    // Con un solo thread o un solo intervallo non serve svegliare i worker
+    if (workers.empty() || count <= grain) {
+        for (unsigned int i = 0; i < count; i++) {
+            task(0, i);
+        }
+        return;
+    }
+
+    // Gli intervalli vengono assegnati a turno, cosi' ogni coda e' ordinata per indice crescente
+    // e i thread avanzano all'incirca nello stesso ordine degli indici
+    unsigned int queueIndex = 0;
+    for (unsigned int begin = 0; begin < count; begin += grain) {
+        unsigned int end = count - begin > grain ? begin + grain : count;
+        queues[queueIndex]->ranges.push_back({ begin, end });
+        queueIndex = (queueIndex + 1) % size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = &task;
+        activeWorkers = (unsigned int)workers.size();
+        generation++;
+    }
+    wakeCondition.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this] { return activeWorkers == 0; });
+    currentTask = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned int threadIndex) {
+    unsigned int seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        runTasks(threadIndex);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeWorkers--;
+        }
+        doneCondition.notify_one();
+    }
+}
+
+void ThreadPool::runTasks(unsigned int threadIndex) {
+    Range range;
+    while (popRange(threadIndex, range)) {
+        for (unsigned int i = range.begin; i < range.end; i++) {
+            (*currentTask)(threadIndex, i);
+        }
+    }
+}
+
+bool ThreadPool::popRange(unsigned int threadIndex, Range& range) {
+    // Prima il fronte della propria coda...
+    {
+        WorkQueue& own = *queues[threadIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.ranges.empty()) {
+            range = own.ranges.front();
+            own.ranges.pop_front();
+            return true;
+        }
+    }
+
+    // ...poi il fondo delle code degli altri thread
+    for (unsigned int offset = 1; offset < size(); offset++) {
+        WorkQueue& victim = *queues[(threadIndex + offset) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.back();
+            victim.ranges.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void FrameSequencer::waitTurn(unsigned int frameIndex) {
+    std::unique_lock<std::mutex> lock(mutex);
+    turnCondition.wait(lock, [&] { return nextFrame == frameIndex; });
+}
+
+void FrameSequencer::finish(unsigned int frameIndex) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        nextFrame = frameIndex + 1;
+    }
+    turnCondition.notify_all();
+}
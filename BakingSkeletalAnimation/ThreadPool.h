@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool di thread persistente con work stealing. parallelFor divide gli indici in intervalli e li assegna
+// a turno alle code dei thread: ogni thread consuma dal fronte della propria coda e, quando la esaurisce,
+// ruba l'ultimo intervallo dalla coda di un altro thread. Il thread chiamante partecipa come thread 0.
+// Non e' prevista la chiamata di parallelFor da piu' thread contemporaneamente o dall'interno di un task.
+class ThreadPool {
+public:
+    using Task = std::function<void(unsigned int threadIndex, unsigned int index)>;
+
+    // numThreads comprende il thread chiamante; 0 usa tutti i core disponibili
+    explicit ThreadPool(unsigned int numThreads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int size() const { return (unsigned int)queues.size(); }
+
+    // Esegue task(threadIndex, index) per ogni index in [0, count), a intervalli di grain indici,
+    // e ritorna quando tutti i task sono terminati
+    void parallelFor(unsigned int count, unsigned int grain, const Task& task);
+
+private:
+    struct Range {
+        unsigned int begin;
+        unsigned int end;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    void workerLoop(unsigned int threadIndex);
+    void runTasks(unsigned int threadIndex);
+    bool popRange(unsigned int threadIndex, Range& range);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    const Task* currentTask = nullptr;
+    unsigned int generation = 0;
+    unsigned int activeWorkers = 0;
+    bool stopping = false;
+};
+
+// Scrittura ordinata dei frame calcolati in parallelo: ogni frame attende che tutti i precedenti
+// siano stati scritti prima di scrivere il proprio risultato.
+class FrameSequencer {
+public:
+    void waitTurn(unsigned int frameIndex);
+    void finish(unsigned int frameIndex);
+
+private:
+    std::mutex mutex;
+    std::condition_variable turnCondition;
+    unsigned int nextFrame = 0;
+};
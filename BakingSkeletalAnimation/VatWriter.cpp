@@ -0,0 +1,173 @@
+#include "VatWriter.h"
+
+#include <cmath>
+#include <limits>
+
+#include "HalfFloat.h"
+#include "ObjWriter.h"
+
+static const unsigned int VAT_CHANNELS = 4;
+
+static void storeTexel(float value, float& texel) {
+    texel = value;
+}
+
+static void storeTexel(float value, uint16_t& texel) {
+    texel = floatToHalf(value);
+}
+
+// Nome del file senza cartella, usato per i riferimenti nel file di descrizione
+static std::string fileName(const std::string& path) {
+    size_t separator = path.find_last_of("/\\");
+    return separator == std::string::npos ? path : path.substr(separator + 1);
+}
+
+static void writeJsonString(std::ostream& output, const std::string& text) {
+    output << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            output << '\\' << c;
+        }
+        else if ((unsigned char)c < ' ') {
+            output << ' ';
+        }
+        else {
+            output << c;
+        }
+    }
+    output << '"';
+}
+
+bool VatWriter::open(const std::string& basePath, const std::vector<BakeMesh>& meshes, VatFormat format, bool writeNormals) {
+    this->basePath = basePath;
+    this->format = format;
+    this->writeNormals = writeNormals;
+    width = 0;
+    for (const BakeMesh& mesh : meshes) {
+        meshNames.push_back(mesh.name);
+        meshVertices.push_back(mesh.numVertices());
+        width += mesh.numVertices();
+    }
+
+    // Bind pose con lo stesso ordine dei texel, per costruire la mesh da animare con la VAT
+    std::ofstream meshFile(basePath + "_vat.obj");
+    if (!meshFile.is_open()) {
+        return false;
+    }
+    ObjWriter meshWriter(meshFile);
+    SkinnedMesh bindPose;
+    for (const BakeMesh& mesh : meshes) {
+        bindPose.positions = mesh.positions;
+        bindPose.normals = mesh.normals;
+        meshWriter.writeMesh(mesh, bindPose);
+    }
+    if (!meshWriter.flush()) {
+        return false;
+    }
+
+    positionsFile.open(basePath + "_vat_positions.raw", std::ios::binary);
+    if (writeNormals) {
+        normalsFile.open(basePath + "_vat_normals.raw", std::ios::binary);
+    }
+    return positionsFile.is_open() && (!writeNormals || normalsFile.is_open());
+}
+
+template <typename Texel>
+bool VatWriter::writeRow(std::ofstream& file, const std::vector<SkinnedMesh>& skinnedMeshes, bool normals, std::vector<Texel>& row) {
+    row.assign((size_t)width * VAT_CHANNELS, Texel());
+    Texel* texel = row.data();
+    for (const SkinnedMesh& skinnedMesh : skinnedMeshes) {
+        const VertexStream& stream = normals ? skinnedMesh.normals : skinnedMesh.positions;
+        const size_t numVertices = skinnedMesh.positions.size();
+        // Una mesh senza normali lascia i propri texel a zero
+        for (size_t i = 0; i < numVertices && !stream.empty(); i++) {
+            storeTexel(stream.x[i], texel[i * VAT_CHANNELS]);
+            storeTexel(stream.y[i], texel[i * VAT_CHANNELS + 1]);
+            storeTexel(stream.z[i], texel[i * VAT_CHANNELS + 2]);
+        }
+        texel += numVertices * VAT_CHANNELS;
+    }
+    file.write(reinterpret_cast<const char*>(row.data()), (std::streamsize)(row.size() * sizeof(Texel)));
+    return !file.fail();
+}
+
+bool VatWriter::writeFrame(const std::vector<SkinnedMesh>& skinnedMeshes) {
+    for (const SkinnedMesh& skinnedMesh : skinnedMeshes) {
+        bounds.add(skinnedMesh.positions);
+    }
+
+    bool written = format == VatFormat::Half
+        ? writeRow(positionsFile, skinnedMeshes, false, halfRow)
+        : writeRow(positionsFile, skinnedMeshes, false, floatRow);
+    if (written && writeNormals) {
+        written = format == VatFormat::Half
+            ? writeRow(normalsFile, skinnedMeshes, true, halfRow)
+            : writeRow(normalsFile, skinnedMeshes, true, floatRow);
+    }
+    failed = failed || !written;
+    framesWritten++;
+    return written;
+}
+
+bool VatWriter::close(const std::vector<float>& frameTimes) {
+    // close su uno stream mai aperto imposta failbit, per cui le normali si chiudono solo se richieste
+    positionsFile.close();
+    if (positionsFile.fail()) {
+        failed = true;
+    }
+    if (writeNormals) {
+        normalsFile.close();
+        failed = failed || normalsFile.fail();
+    }
+
+    // Senza vertici il box resta vuoto e viene scritto come zero. Posizioni inf o nan renderebbero il JSON
+    // non valido e la VAT inutilizzabile, per cui la descrizione non viene scritta
+    if (!bounds.finite) {
+        return false;
+    }
+    float boundsMin[3] = { 0.0f, 0.0f, 0.0f };
+    float boundsMax[3] = { 0.0f, 0.0f, 0.0f };
+    if (!bounds.empty()) {
+        for (int c = 0; c < 3; c++) {
+            boundsMin[c] = bounds.minimum[c];
+            boundsMax[c] = bounds.maximum[c];
+        }
+    }
+
+    std::ofstream description(basePath + "_vat.json");
+    if (!description.is_open()) {
+        return false;
+    }
+    description.precision(std::numeric_limits<float>::max_digits10);
+    description << "{\n";
+    description << "  \"width\": " << width << ",\n";
+    description << "  \"height\": " << framesWritten << ",\n";
+    description << "  \"format\": \"" << (format == VatFormat::Half ? "float16" : "float32") << "\",\n";
+    description << "  \"channels\": " << VAT_CHANNELS << ",\n";
+    description << "  \"mesh\": ";
+    writeJsonString(description, fileName(basePath + "_vat.obj"));
+    description << ",\n  \"positions\": ";
+    writeJsonString(description, fileName(basePath + "_vat_positions.raw"));
+    if (writeNormals) {
+        description << ",\n  \"normals\": ";
+        writeJsonString(description, fileName(basePath + "_vat_normals.raw"));
+    }
+    description << ",\n  \"boundsMin\": [" << boundsMin[0] << ", " << boundsMin[1] << ", " << boundsMin[2] << "]";
+    description << ",\n  \"boundsMax\": [" << boundsMax[0] << ", " << boundsMax[1] << ", " << boundsMax[2] << "]";
+    description << ",\n  \"frameTimes\": [";
+    for (size_t i = 0; i < frameTimes.size(); i++) {
+        description << (i > 0 ? ", " : "") << frameTimes[i];
+    }
+    description << "],\n  \"meshes\": [";
+    unsigned int firstVertex = 0;
+    for (size_t i = 0; i < meshNames.size(); i++) {
+        description << (i > 0 ? "," : "") << "\n    { \"name\": ";
+        writeJsonString(description, meshNames[i]);
+        description << ", \"firstVertex\": " << firstVertex << ", \"numVertices\": " << meshVertices[i] << " }";
+        firstVertex += meshVertices[i];
+    }
+    description << "\n  ]\n}\n";
+    description.close();
+
+    return !failed && !description.fail();
+}
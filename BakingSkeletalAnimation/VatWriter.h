@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "BakeMesh.h"
+#include "Skinning.h"
+
+// Formato dei texel delle vertex animation texture
+enum class VatFormat {
+    Float, // RGBA float32
+    Half   // RGBA half IEEE
+};
+
+// Scrittura di una clip come vertex animation texture (VAT): una riga per frame e un texel per vertice,
+// con i vertici di tutte le mesh uno dopo l'altro. I texel sono RGBA con alfa a zero, in file raw senza
+// intestazione (<base>_vat_positions.raw e, se richiesto, <base>_vat_normals.raw).
+// Accanto vengono scritti <base>_vat.obj, la bind pose con lo stesso ordine dei vertici (il texel u
+// corrisponde al vertice OBJ u + 1), e <base>_vat.json con dimensioni, formato, frame e limiti delle posizioni.
+class VatWriter {
+public:
+    bool open(const std::string& basePath, const std::vector<BakeMesh>& meshes, VatFormat format, bool writeNormals);
+
+    // Accoda la riga del frame successivo; skinnedMeshes segue l'ordine delle mesh passate a open
+    bool writeFrame(const std::vector<SkinnedMesh>& skinnedMeshes);
+
+    // Chiude le texture e scrive il file di descrizione
+    bool close(const std::vector<float>& frameTimes);
+
+private:
+    template <typename Texel>
+    bool writeRow(std::ofstream& file, const std::vector<SkinnedMesh>& skinnedMeshes, bool normals, std::vector<Texel>& row);
+
+    std::string basePath;
+    std::vector<std::string> meshNames;
+    std::vector<unsigned int> meshVertices;
+    VatFormat format = VatFormat::Float;
+    bool writeNormals = false;
+    unsigned int width = 0;
+    unsigned int framesWritten = 0;
+    std::ofstream positionsFile;
+    std::ofstream normalsFile;
+    std::vector<float> floatRow;
+    std::vector<uint16_t> halfRow;
+    BoundingBox bounds;
+    bool failed = false;
+};
@@ -1,227 +1,374 @@
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <random>
+#include <string>
 #include <vector>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <assimp/matrix4x4.h>
 
-void writeMeshToObj(const aiMesh* mesh, std::ofstream& outputFile);
-aiMatrix4x4 interpolateTransformation(float animationTime, const aiNodeAnim* nodeAnim);
-void applyPoseToMesh(const aiMesh* mesh, const aiAnimation* animation, float animationTime, const aiScene* scene);
-aiMatrix4x4 calculateGlobalTransformations(const aiNode* node, const aiAnimation* animation, float animationTime, const aiScene* scene);
+#include "AnimationBinding.h"
+#include "BakeFile.h"
+#include "BakeMesh.h"
+#include "BakeSequence.h"
+#include "BakeSettings.h"
+#include "MappedFile.h"
+#include "MappedIOSystem.h"
+#include "ObjWriter.h"
+#include "Pose.h"
+#include "Profiler.h"
+#include "SampledTracks.h"
+#include "SceneCache.h"
+#include "Skeleton.h"
+#include "Skinning.h"
+#include "SyntheticScene.h"
+#include "ThreadPool.h"
 
-int main() {
-    // Inizializza l'importer di Assimp
+// Stato di lavoro di un thread del bake
+struct FrameWorkspace {
+    FrameWorkspace(const Skeleton& skeleton, unsigned int numMeshes) : poseCache(skeleton), skinnedMeshes(numMeshes) {}
+
+    PoseCache poseCache;
+    std::vector<SkinnedMesh> skinnedMeshes;
+    BakeFileFrame binaryFrame;
+    BakeSequenceGroup sequenceGroup;
+};
+
+int main(int argc, char* argv[]) {
+    BakeSettings settings;
+    if (!parseBakeSettings(argc, argv, settings)) {
+        return -1;
+    }
+
+    // Le misure vanno attivate prima dell'importazione e dell'avvio dei thread
+    if (!settings.profilePath.empty() && !enableProfiling()) {
+        std::cout << "La profilazione e' stata esclusa dalla compilazione (BAKE_ENABLE_PROFILING=0)" << std::endl;
+    }
+
+    // Inizializza l'importer di Assimp. I file di ingresso vengono mappati in memoria invece di essere
+    // letti con stdio; l'importer diventa proprietario dell'IOSystem
     Assimp::Importer importer;
+    importer.SetIOHandler(new MappedIOSystem());
 
     // Specifica le opzioni di importazione, in questo caso, vogliamo caricare i dati relativi alle ossa
-    unsigned int importFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_LimitBoneWeights;
-    const aiScene* scene = importer.ReadFile("Mesh/AnimatedSkeletalMeshASCII.fbx", importFlags);
+    unsigned int importFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_LimitBoneWeights | aiProcess_PopulateArmatureData;
+    std::unique_ptr<aiScene> syntheticScene;
+    const aiScene* scene = nullptr;
+    {
+        PROFILE_SCOPE("import");
+        if (settings.syntheticInput) {
+            syntheticScene = buildSyntheticScene(settings.syntheticScene);
+            scene = syntheticScene.get();
+        }
+        else {
+            // Con la cache la scena gia' post-processata viene riletta invece di importare di nuovo il file
+            SceneCacheKey cacheKey;
+            const bool useCache = !settings.sceneCachePath.empty() && computeSceneCacheKey(settings.inputPath, importFlags, cacheKey);
+            if (useCache) {
+                scene = loadSceneCache(importer, settings.sceneCachePath, cacheKey);
+            }
+            if (!scene) {
+                scene = importer.ReadFile(settings.inputPath, importFlags);
+                if (useCache && scene && !(scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) && !saveSceneCache(settings.sceneCachePath, cacheKey, scene)) {
+                    std::cout << "Impossibile salvare la scena nel file " << settings.sceneCachePath << std::endl;
+                }
+            }
+        }
+    }
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
         std::cout << "Errore durante il caricamento della mesh skinnata: " << importer.GetErrorString() << std::endl;
         return -1;
     }
 
-    // Seleziona la prima animazione dalla scena
-    aiAnimation* animation = scene->mAnimations[0];
+    if (settings.animationIndex >= scene->mNumAnimations) {
+        std::cout << "La scena non contiene l'animazione " << settings.animationIndex << " (animazioni presenti: " << scene->mNumAnimations << ")" << std::endl;
+        return -1;
+    }
 
-    // Seleziona il frame desiderato (es. frame 10)
-    float desiredTime = 0.0f;
+    // Seleziona l'animazione richiesta dalla scena
+    aiAnimation* animation = scene->mAnimations[settings.animationIndex];
 
-    // Applica la posa a tutte le mesh nella scena
-    for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
-        applyPoseToMesh(scene->mMeshes[i], animation, desiredTime, scene);
+    // Compila una sola volta la gerarchia e associa i canali dell'animazione ai suoi nodi
+    Skeleton skeleton;
+    AnimationBinding binding;
+    {
+        PROFILE_SCOPE("binding");
+        skeleton = buildSkeleton(scene);
+        binding = buildAnimationBinding(skeleton, animation);
     }
 
-    // Scrivi la mesh risultante in formato OBJ
-    std::ofstream outputFile("Mesh/OutputMesh.obj");
-    if (!outputFile.is_open()) {
-        std::cout << "Impossibile aprire il file OutputMesh.obj per la scrittura." << std::endl;
+    // Istanti dei frame da calcolare, in tick dell'animazione
+    std::vector<float> frameTimes;
+    if (!computeFrameTimes(settings, animation, frameTimes)) {
         return -1;
     }
 
-    // Scrivi tutte le mesh in formato OBJ
+    // Converte una sola volta la geometria e i dati di skinning di ogni mesh. La bind pose viene
+    // solo letta, per cui i frame possono essere calcolati in parallelo
+    std::vector<BakeMesh> meshes(scene->mNumMeshes);
+    std::vector<SkinningData> skinnings(scene->mNumMeshes);
     for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
-        writeMeshToObj(scene->mMeshes[i], outputFile);
+        PROFILE_SCOPE("mesh conversion");
+        meshes[i] = buildBakeMesh(scene->mMeshes[i]);
+        skinnings[i] = buildSkinningData(scene->mMeshes[i], skeleton);
+        if (meshes[i].numSkippedFaces > 0) {
+            std::cout << "Il formato OBJ supporta solo triangoli. La mesh " << i << " contiene " << meshes[i].numSkippedFaces << " facce che non sono triangoli e verranno ignorate." << std::endl;
+        }
     }
 
-    // Chiudi il file
-    outputFile.close();
+    // Il kernel va scelto prima di avviare i thread
+    if (!setSkinningKernel(settings.skinningKernel)) {
+        std::cout << "Il kernel di skinning " << skinningKernelName(settings.skinningKernel) << " non e' supportato da questa CPU" << std::endl;
+        return -1;
+    }
 
-    return 0;
-}
+    // Con piu' frame i thread si dividono i frame (non servono piu' thread che frame),
+    // con un solo frame si dividono i vertici delle mesh grandi
+    const bool parallelFrames = frameTimes.size() > 1;
+    unsigned int numThreads = settings.numThreads > 0 ? settings.numThreads : std::thread::hardware_concurrency();
+    if (parallelFrames) {
+        numThreads = std::min(numThreads, (unsigned int)frameTimes.size());
+    }
+    ThreadPool threadPool(std::max(1u, numThreads));
 
-void writeMeshToObj(const aiMesh* mesh, std::ofstream& outputFile) {
-    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-        aiVector3D vertex = mesh->mVertices[i];
-        outputFile << "v " << vertex.x << " " << vertex.y << " " << vertex.z << std::endl;
+    // Ogni thread ha la propria cache delle pose e i propri buffer di uscita, riusati per tutti i suoi frame
+    std::vector<FrameWorkspace> workspaces;
+    workspaces.reserve(threadPool.size());
+    for (unsigned int i = 0; i < (parallelFrames ? threadPool.size() : 1); i++) {
+        workspaces.emplace_back(skeleton, scene->mNumMeshes);
     }
 
-    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
-        if (face.mNumIndices != 3) {
-            std::cout << "Il formato OBJ supporta solo triangoli. La mesh contiene facce con " << face.mNumIndices << " vertici." << std::endl;
-            return;
-        }
-        outputFile << "f ";
-        for (unsigned int j = 0; j < face.mNumIndices; j++) {
-            outputFile << face.mIndices[j] + 1 << " "; // Gli indici OBJ partono da 1
+    // Con piu' frame le pose leggono i canali gia' ricampionati sugli istanti del bake
+    SampledTracks tracks;
+    if (parallelFrames && settings.sampledTracks) {
+        PROFILE_SCOPE("sample tracks");
+        uint64_t fingerprint = computeTracksFingerprint(skeleton, binding, frameTimes);
+        if (settings.trackCachePath.empty() || !loadSampledTracks(settings.trackCachePath, fingerprint, skeleton, tracks)) {
+            tracks = sampleTracks(skeleton, binding, frameTimes, &threadPool);
+            if (!settings.trackCachePath.empty() && !saveSampledTracks(settings.trackCachePath, tracks)) {
+                std::cout << "Impossibile salvare le tracce nel file " << settings.trackCachePath << std::endl;
+            }
         }
-        outputFile << std::endl;
     }
-}
 
-aiMatrix4x4 interpolateTransformation(float animationTime, const aiNodeAnim* nodeAnim) {
-    aiMatrix4x4 transformation;
-
-    // Interpolazione della traslazione
-    if (nodeAnim->mNumPositionKeys == 1) {
-        transformation = aiMatrix4x4(); // Inizializza come matrice identit
-        transformation.a4 = nodeAnim->mPositionKeys[0].mValue.x;
-        transformation.b4 = nodeAnim->mPositionKeys[0].mValue.y;
-        transformation.c4 = nodeAnim->mPositionKeys[0].mValue.z;
-    }
-    else {
-        unsigned int frameIndex = 0;
-        for (unsigned int i = 0; i < nodeAnim->mNumPositionKeys - 1; i++) {
-            if (animationTime < nodeAnim->mPositionKeys[i + 1].mTime) {
-                frameIndex = i;
-                break;
-            }
+    // Applica la posa del frame a tutte le mesh nella scena
+    auto poseFrame = [&](FrameWorkspace& workspace, unsigned int frame) {
+        for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+            const BakeMesh& mesh = meshes[i];
+            ThreadPool* vertexThreadPool = !parallelFrames && useParallelSkinning(settings.skinningMode, mesh.numVertices(), settings.parallelSkinningThreshold) ? &threadPool : nullptr;
+            const std::vector<aiMatrix4x4>& globalTransformations = tracks.empty()
+                ? workspace.poseCache.evaluate(binding, frameTimes[frame], skinnings[i].armatureIndex)
+                : workspace.poseCache.evaluate(tracks, frame, skinnings[i].armatureIndex);
+            applyPoseToMesh(mesh, skinnings[i], skeleton, globalTransformations, workspace.skinnedMeshes[i], vertexThreadPool);
+        }
+    };
+
+    // Esegue task per count frame (o gruppi di frame), in parallelo se la clip ha piu' frame
+    auto runTasks = [&](unsigned int count, const ThreadPool::Task& task) {
+        if (parallelFrames) {
+            threadPool.parallelFor(count, 1, task);
         }
-        unsigned int nextFrameIndex = (frameIndex + 1) % nodeAnim->mNumPositionKeys;
-        float deltaTime = (float)(nodeAnim->mPositionKeys[nextFrameIndex].mTime - nodeAnim->mPositionKeys[frameIndex].mTime);
-        float factor = (animationTime - (float)nodeAnim->mPositionKeys[frameIndex].mTime) / deltaTime;
-        const aiVector3D& startPosition = nodeAnim->mPositionKeys[frameIndex].mValue;
-        const aiVector3D& endPosition = nodeAnim->mPositionKeys[nextFrameIndex].mValue;
-        aiVector3D interpolatedPosition = startPosition + factor * (endPosition - startPosition);
-
-        transformation = aiMatrix4x4(); // Inizializza come matrice identit
-        transformation.a4 = interpolatedPosition.x;
-        transformation.b4 = interpolatedPosition.y;
-        transformation.c4 = interpolatedPosition.z;
-    }
-
-    // Interpolazione della rotazione
-    if (nodeAnim->mNumRotationKeys == 1) {
-        aiQuaternion rotationQ = nodeAnim->mRotationKeys[0].mValue;
-        aiMatrix4x4 rotationMatrix = aiMatrix4x4(rotationQ.GetMatrix());
-        transformation *= rotationMatrix;
-    }
-    else {
-        unsigned int frameIndex = 0;
-        for (unsigned int i = 0; i < nodeAnim->mNumRotationKeys - 1; i++) {
-            if (animationTime < nodeAnim->mRotationKeys[i + 1].mTime) {
-                frameIndex = i;
-                break;
+        else {
+            for (unsigned int i = 0; i < count; i++) {
+                task(0, i);
             }
         }
-        unsigned int nextFrameIndex = (frameIndex + 1) % nodeAnim->mNumRotationKeys;
-        float deltaTime = (float)(nodeAnim->mRotationKeys[nextFrameIndex].mTime - nodeAnim->mRotationKeys[frameIndex].mTime);
-        float factor = (animationTime - (float)nodeAnim->mRotationKeys[frameIndex].mTime) / deltaTime;
-        const aiQuaternion& startRotationQ = nodeAnim->mRotationKeys[frameIndex].mValue;
-        const aiQuaternion& endRotationQ = nodeAnim->mRotationKeys[nextFrameIndex].mValue;
-        aiQuaternion interpolatedRotationQ;
-        aiQuaternion::Interpolate(interpolatedRotationQ, startRotationQ, endRotationQ, factor);
-        interpolatedRotationQ.Normalize();
-        aiMatrix4x4 rotationMatrix = aiMatrix4x4(interpolatedRotationQ.GetMatrix());
-        transformation *= rotationMatrix;
-    }
-
-    // Interpolazione dello scaling
-    if (nodeAnim->mNumScalingKeys == 1) {
-        aiVector3D scale = nodeAnim->mScalingKeys[0].mValue;
-        aiMatrix4x4 scalingMatrix;
-        scalingMatrix.a1 = scale.x; scalingMatrix.a2 = 0.0f; scalingMatrix.a3 = 0.0f; scalingMatrix.a4 = 0.0f;
-        scalingMatrix.b1 = 0.0f; scalingMatrix.b2 = scale.y; scalingMatrix.b3 = 0.0f; scalingMatrix.b4 = 0.0f;
-        scalingMatrix.c1 = 0.0f; scalingMatrix.c2 = 0.0f; scalingMatrix.c3 = scale.z; scalingMatrix.c4 = 0.0f;
-        scalingMatrix.d1 = 0.0f; scalingMatrix.d2 = 0.0f; scalingMatrix.d3 = 0.0f; scalingMatrix.d4 = 1.0f;
-        transformation *= scalingMatrix;
-    }
-    else {
-        unsigned int frameIndex = 0;
-        for (unsigned int i = 0; i < nodeAnim->mNumScalingKeys - 1; i++) {
-            if (animationTime < nodeAnim->mScalingKeys[i + 1].mTime) {
-                frameIndex = i;
-                break;
+    };
+
+    const bool writeObj = settings.outputFormat == OutputFormat::Obj || settings.outputFormat == OutputFormat::Both;
+    const bool writeBinary = settings.outputFormat == OutputFormat::Binary || settings.outputFormat == OutputFormat::Both;
+    const bool writeVat = settings.outputFormat == OutputFormat::Vat;
+    const bool writeSequence = settings.outputFormat == OutputFormat::Sequence;
+
+    // La quantizzazione Unorm16 (anche del file .bakeseq) usa il box di ogni mesh sull'intera clip:
+    // un primo passaggio calcola le pose solo per misurarlo
+    std::vector<BoundingBox> clipBounds(scene->mNumMeshes);
+    if ((writeBinary && settings.binaryEncoding.positions == PositionEncoding::Unorm16) || writeSequence) {
+        PROFILE_SCOPE("clip bounds");
+        std::vector<std::vector<BoundingBox>> threadBounds(workspaces.size(), clipBounds);
+        runTasks((unsigned int)frameTimes.size(), [&](unsigned int threadIndex, unsigned int frame) {
+            poseFrame(workspaces[threadIndex], frame);
+            for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+                threadBounds[threadIndex][i].add(workspaces[threadIndex].skinnedMeshes[i].positions);
+            }
+        });
+        for (const std::vector<BoundingBox>& bounds : threadBounds) {
+            for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+                clipBounds[i].add(bounds[i]);
             }
         }
-        unsigned int nextFrameIndex = (frameIndex + 1) % nodeAnim->mNumScalingKeys;
-        float deltaTime = (float)(nodeAnim->mScalingKeys[nextFrameIndex].mTime - nodeAnim->mScalingKeys[frameIndex].mTime);
-        float factor = (animationTime - (float)nodeAnim->mScalingKeys[frameIndex].mTime) / deltaTime;
-        const aiVector3D& startScaling = nodeAnim->mScalingKeys[frameIndex].mValue;
-        const aiVector3D& endScaling = nodeAnim->mScalingKeys[nextFrameIndex].mValue;
-        aiVector3D interpolatedScaling = startScaling + factor * (endScaling - startScaling);
-        aiMatrix4x4 scalingMatrix;
-        scalingMatrix.a1 = interpolatedScaling.x; scalingMatrix.a2 = 0.0f; scalingMatrix.a3 = 0.0f; scalingMatrix.a4 = 0.0f;
-        scalingMatrix.b1 = 0.0f; scalingMatrix.b2 = interpolatedScaling.y; scalingMatrix.b3 = 0.0f; scalingMatrix.b4 = 0.0f;
-        scalingMatrix.c1 = 0.0f; scalingMatrix.c2 = 0.0f; scalingMatrix.c3 = interpolatedScaling.z; scalingMatrix.c4 = 0.0f;
-        scalingMatrix.d1 = 0.0f; scalingMatrix.d2 = 0.0f; scalingMatrix.d3 = 0.0f; scalingMatrix.d4 = 1.0f;
-        transformation *= scalingMatrix;
-    }
-
-    return transformation;
-}
+    }
 
-void applyPoseToMesh(const aiMesh* mesh, const aiAnimation* animation, float animationTime, const aiScene* scene) {
-    if (!mesh->HasBones()) {
-        // La mesh non ha ossa, quindi non c' bisogno di applicare una posa.
-        return;
+    // Il file binario e la VAT contengono tutti i frame: vengono aperti prima del bake e i frame vi sono accodati in ordine
+    BakeFileWriter binaryWriter;
+    std::string binaryPath = binaryOutputPath(settings.outputPath);
+    if (writeBinary && !binaryWriter.open(binaryPath, meshes, frameTimes, settings.binaryEncoding, &clipBounds)) {
+        std::cout << "Impossibile aprire il file " << binaryPath << " per la scrittura." << std::endl;
+        return -1;
+    }
+    VatWriter vatWriter;
+    std::string vatPath = outputBasePath(settings.outputPath);
+    if (writeVat && !vatWriter.open(vatPath, meshes, settings.vatFormat, settings.vatNormals)) {
+        std::cout << "Impossibile creare i file della VAT " << vatPath << "_vat.*" << std::endl;
+        return -1;
+    }
+    BakeSequenceWriter sequenceWriter;
+    std::string sequencePath = sequenceOutputPath(settings.outputPath);
+    if (writeSequence && !sequenceWriter.open(sequencePath, meshes, frameTimes, clipBounds, settings.keyframeInterval)) {
+        std::cout << "Impossibile aprire il file " << sequencePath << " per la scrittura." << std::endl;
+        return -1;
     }
 
-    aiMatrix4x4 globalTransformation = calculateGlobalTransformations(scene->mRootNode, animation, animationTime, scene);
+    FrameSequencer sequencer;
+    std::atomic<bool> failed(false);
 
-    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-        aiVector3D vertex = mesh->mVertices[i];
-        aiVector3D normal = mesh->mNormals ? mesh->mNormals[i] : aiVector3D(0.0f, 0.0f, 0.0f);
+    // Attende il turno del frame (o del gruppo) nella scrittura ordinata
+    auto waitTurn = [&](unsigned int index) {
+        PROFILE_SCOPE("wait turn");
+        sequencer.waitTurn(index);
+    };
 
-        // Applica la posa al vertice e alla normale utilizzando le trasformazioni degli ossi associati al vertice
-        aiVector3D transformedVertex = globalTransformation * vertex;
-        aiVector3D transformedNormal = globalTransformation * normal;
+    auto bakeFrame = [&](unsigned int threadIndex, unsigned int frame) {
+        PROFILE_SCOPE("frame");
+        FrameWorkspace& workspace = workspaces[threadIndex];
+        poseFrame(workspace, frame);
 
-        // Applica la traslazione e lo scaling della mesh
-        aiVector3D translation = mesh->mVertices[i] - transformedVertex;
-        transformedVertex += translation;
+        // Ogni frame OBJ ha il proprio file, per cui i thread scrivono senza attendersi
+        if (writeObj) {
+            PROFILE_SCOPE("write obj");
+            std::string outputPath = frameOutputPath(settings.outputPath, frame, frameTimes.size());
+            std::ofstream outputFile(outputPath);
+            if (outputFile.is_open()) {
+                ObjWriter writer(outputFile, settings.objPrecision);
+                for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+                    writer.writeMesh(meshes[i], workspace.skinnedMeshes[i]);
+                }
+                if (!writer.flush()) {
+                    std::cout << "Errore durante la scrittura del file " << outputPath << std::endl;
+                    failed = true;
+                }
+            }
+            else {
+                std::cout << "Impossibile aprire il file " << outputPath << " per la scrittura." << std::endl;
+                failed = true;
+            }
+        }
 
-        if (mesh->mNormals) {
-            transformedNormal.Normalize(); // Normalize again after applying the translation
+        // Nel file binario e nella VAT i frame vengono scritti nell'ordine dei frame
+        if (writeBinary) {
+            PROFILE_SCOPE("encode bake");
+            binaryWriter.encodeFrame(workspace.skinnedMeshes, workspace.binaryFrame);
         }
+        if (writeBinary || writeVat) {
+            waitTurn(frame);
+            PROFILE_SCOPE("write frame");
+            if (writeBinary && !binaryWriter.writeFrame(workspace.binaryFrame)) {
+                failed = true;
+            }
+            if (writeVat && !vatWriter.writeFrame(workspace.skinnedMeshes)) {
+                failed = true;
+            }
+            sequencer.finish(frame);
+        }
+    };
 
-        // Assegna il vertice trasformato alla mesh
-        mesh->mVertices[i] = transformedVertex;
-        if (mesh->mNormals) {
-            mesh->mNormals[i] = transformedNormal;
+    // Nel file .bakeseq i frame di un gruppo dipendono dai precedenti: ogni thread calcola e codifica
+    // un gruppo intero, e i gruppi vengono scritti in ordine
+    auto bakeSequenceGroup = [&](unsigned int threadIndex, unsigned int group) {
+        PROFILE_SCOPE("group");
+        FrameWorkspace& workspace = workspaces[threadIndex];
+        sequenceWriter.beginGroup(workspace.sequenceGroup);
+        for (unsigned int frame = sequenceWriter.groupFirstFrame(group); frame < sequenceWriter.groupEndFrame(group); frame++) {
+            poseFrame(workspace, frame);
+            PROFILE_SCOPE("encode seq");
+            sequenceWriter.encodeFrame(workspace.skinnedMeshes, workspace.sequenceGroup);
         }
-    }
-}
+        waitTurn(group);
+        PROFILE_SCOPE("write group");
+        if (!sequenceWriter.writeGroup(workspace.sequenceGroup)) {
+            failed = true;
+        }
+        sequencer.finish(group);
+    };
 
-aiMatrix4x4 calculateGlobalTransformations(const aiNode* node, const aiAnimation* animation, float animationTime, const aiScene* scene) {
-    aiMatrix4x4 globalTransformation;
+    {
+        PROFILE_SCOPE("bake");
+        if (writeSequence) {
+            runTasks(sequenceWriter.numGroups(), bakeSequenceGroup);
+        }
+        else {
+            runTasks((unsigned int)frameTimes.size(), bakeFrame);
+        }
+    }
 
-    const aiNodeAnim* nodeAnim = nullptr;
-    for (unsigned int i = 0; i < animation->mNumChannels; i++) {
-        if (animation->mChannels[i]->mNodeName == node->mName) {
-            nodeAnim = animation->mChannels[i];
-            break;
+    if (writeBinary && !binaryWriter.close()) {
+        std::cout << "Errore durante la scrittura del file " << binaryPath << std::endl;
+        failed = true;
+    }
+    if (writeBinary && (settings.binaryEncoding.positions != PositionEncoding::Float32 || settings.binaryEncoding.normals != NormalEncoding::Float32)) {
+        for (size_t i = 0; i < binaryWriter.meshes().size(); i++) {
+            const BakeFileMesh& mesh = binaryWriter.meshes()[i];
+            std::cout << "Mesh " << i << " (" << mesh.name << "): errore massimo posizioni " << mesh.maxPositionError
+                << ", normali " << mesh.maxNormalError << " gradi" << std::endl;
+        }
+    }
+    if (writeSequence && !sequenceWriter.close()) {
+        std::cout << "Errore durante la scrittura del file " << sequencePath << std::endl;
+        failed = true;
+    }
+    if (writeSequence) {
+        std::cout << "File " << sequencePath << ": " << sequenceWriter.fileSize() << " byte" << std::endl;
+        for (size_t i = 0; i < sequenceWriter.meshes().size(); i++) {
+            const BakeSequenceMesh& mesh = sequenceWriter.meshes()[i];
+            std::cout << "Mesh " << i << " (" << mesh.name << "): errore massimo posizioni " << mesh.maxPositionError
+                << ", normali " << mesh.maxNormalError << " gradi" << std::endl;
         }
     }
 
-    if (nodeAnim) {
-        globalTransformation = interpolateTransformation(animationTime, nodeAnim);
+    // Rilegge dal file .bakeseq alcuni frame scelti a caso e li confronta con le pose ricalcolate,
+    // entro gli errori massimi registrati per ogni mesh
+    if (writeSequence && settings.verifyFrames > 0 && !failed) {
+        PROFILE_SCOPE("verify");
+        MappedFile sequenceFile;
+        BakeSequenceReader reader;
+        if (!sequenceFile.open(sequencePath, MappedFileAccess::Random) || !reader.open(reinterpret_cast<const char*>(sequenceFile.data()), sequenceFile.size())) {
+            std::cout << "Impossibile rileggere il file " << sequencePath << std::endl;
+            failed = true;
+        }
+        else {
+            std::mt19937 random(settings.verifyFrames);
+            unsigned int numFailedFrames = 0;
+            for (unsigned int i = 0; i < settings.verifyFrames; i++) {
+                unsigned int frame = (unsigned int)(random() % frameTimes.size());
+                poseFrame(workspaces[0], frame);
+                if (!reader.verifyFrame(frame, workspaces[0].skinnedMeshes)) {
+                    std::cout << "Il frame " << frame << " del file " << sequencePath << " non corrisponde alla posa calcolata" << std::endl;
+                    numFailedFrames++;
+                }
+            }
+            std::cout << "Verifica di " << settings.verifyFrames << " frame: " << numFailedFrames << " errati" << std::endl;
+            failed = failed || numFailedFrames > 0;
+        }
     }
-    else {
-        globalTransformation = node->mTransformation;
+    if (writeVat && !vatWriter.close(frameTimes)) {
+        std::cout << "Errore durante la scrittura della VAT " << vatPath << "_vat.*" << std::endl;
+        failed = true;
     }
 
-    for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        const aiNode* childNode = node->mChildren[i];
-        if (childNode) {
-            aiMatrix4x4 childTransform = calculateGlobalTransformations(childNode, animation, animationTime, scene);
-            globalTransformation *= childTransform;
+    if (profilingEnabled()) {
+        printProfileSummary(std::cout);
+        if (writeChromeTrace(settings.profilePath)) {
+            std::cout << "Trace delle fasi salvato nel file " << settings.profilePath << std::endl;
+        }
+        else {
+            std::cout << "Impossibile scrivere il trace nel file " << settings.profilePath << std::endl;
         }
     }
 
-    return globalTransformation;
-}
\ No newline at end of file
+    return failed ? -1 : 0;
+}